@@ -0,0 +1,42 @@
+// Fetch throughput benchmark. Point it at a local server, e.g.
+//   python3 -m http.server 8000
+//   ./bench/fetch_bench http://127.0.0.1:8000/ 2000 64
+#include "../src/http_client.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <url> [requests] [concurrency] [per-host]" << std::endl;
+        return 1;
+    }
+    std::string url = argv[1];
+    int requests = argc > 2 ? std::atoi(argv[2]) : 1000;
+    int concurrency = argc > 3 ? std::atoi(argv[3]) : 64;
+    int perHost = argc > 4 ? std::atoi(argv[4]) : 6;
+
+    HttpClient http(concurrency, perHost);
+    int done = 0, failed = 0;
+    size_t bytes = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < requests; i++) {
+        http.fetchAsync(url, [&](HttpResponse resp) {
+            done++;
+            if (resp.statusCode != 200) failed++;
+            bytes += resp.body.size();
+        });
+    }
+    while (done < requests) {
+        http.update();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << requests << " requests in " << secs * 1000.0 << " ms ("
+              << requests / secs << " req/s, " << bytes / secs / 1e6 << " MB/s)" << std::endl;
+    std::cout << "connections opened: " << http.connectionsOpened() << ", failed: " << failed << std::endl;
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,109 @@
+// Link extraction benchmark: the streaming href scanner against the
+// std::regex extractor it replaced. Pass HTML files to use a real corpus,
+// e.g. pages saved with `curl -o`; without arguments a synthetic page is used.
+//   ./bench/link_bench saved/*.html
+#include "../src/html_parser.h"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <regex>
+#include <set>
+#include <sstream>
+
+// The previous implementation, kept verbatim for comparison
+static std::string normalizeUrlRegex(const std::string& url, const std::string& baseUrl) {
+    if (url.empty() || url[0] == '#') return "";
+    if (url.find("javascript:") == 0 || url.find("mailto:") == 0) return "";
+    if (url.find("http://") == 0 || url.find("https://") == 0) {
+        return url;
+    }
+    std::string base = baseUrl;
+    size_t protoEnd = base.find("://");
+    if (protoEnd == std::string::npos) return "";
+    size_t pathStart = base.find('/', protoEnd + 3);
+    std::string domain = (pathStart != std::string::npos) ? base.substr(0, pathStart) : base;
+    if (url[0] == '/') {
+        return domain + url;
+    } else {
+        if (pathStart != std::string::npos) {
+            size_t lastSlash = base.rfind('/');
+            return base.substr(0, lastSlash + 1) + url;
+        }
+        return domain + "/" + url;
+    }
+}
+
+static std::vector<std::string> extractLinksRegex(const std::string& html, const std::string& baseUrl) {
+    std::vector<std::string> links;
+    std::set<std::string> seen;
+    std::string safeHtml = html.length() > 500000 ? html.substr(0, 500000) : html;
+    try {
+        std::regex hrefRegex(R"(href\s*=\s*["']([^"']+)["'])", std::regex::icase);
+        auto begin = std::sregex_iterator(safeHtml.begin(), safeHtml.end(), hrefRegex);
+        auto end = std::sregex_iterator();
+        for (auto it = begin; it != end; ++it) {
+            std::string normalized = normalizeUrlRegex((*it)[1].str(), baseUrl);
+            if (!normalized.empty() && seen.find(normalized) == seen.end()) {
+                seen.insert(normalized);
+                links.push_back(normalized);
+            }
+        }
+    } catch (...) {
+    }
+    return links;
+}
+
+static std::string syntheticPage() {
+    std::string html = "<!doctype html><html><head><title>Synthetic</title>"
+                       "<link rel=\"stylesheet\" href=\"/static/site.css\"></head><body>\n";
+    for (int i = 0; i < 3000; i++) {
+        html += "<div class=\"card\"><h3>Heading " + std::to_string(i) + "</h3>"
+                "<p>Here is some ordinary paragraph text with the usual share of letters, "
+                "which is what the scanner spends most of its time skipping over.</p>"
+                "<a class=\"more\" href=\"/articles/" + std::to_string(i) + "\">Read more</a></div>\n";
+    }
+    return html + "</body></html>";
+}
+
+template <typename F>
+static double timeIt(F&& fn, int reps) {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; r++) fn();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / reps;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::pair<std::string, std::string>> pages;
+    for (int i = 1; i < argc; i++) {
+        std::ifstream in(argv[i], std::ios::binary);
+        if (!in) {
+            std::cerr << "Cannot read " << argv[i] << std::endl;
+            return 1;
+        }
+        std::stringstream ss;
+        ss << in.rdbuf();
+        pages.push_back({argv[i], ss.str()});
+    }
+    if (pages.empty()) pages.push_back({"synthetic", syntheticPage()});
+
+    const std::string base = "https://example.com/dir/page.html";
+    std::cout << "scanner: " << hrefScannerName() << std::endl;
+
+    double totalRegex = 0.0, totalScan = 0.0;
+    for (const auto& [name, html] : pages) {
+        // The regex path only ever looked at the first 500 KB
+        std::string input = html.substr(0, 500000);
+        size_t regexLinks = 0, scanLinks = 0;
+        double regexTime = timeIt([&] { regexLinks = extractLinksRegex(input, base).size(); }, 3);
+        double scanTime = timeIt([&] { scanLinks = extractLinks(input, base).size(); }, 50);
+        totalRegex += regexTime;
+        totalScan += scanTime;
+
+        double mb = input.size() / 1e6;
+        std::cout << name << ": " << input.size() / 1024 << " KB, regex " << regexTime * 1000.0 << " ms ("
+                  << regexLinks << " links), scanner " << scanTime * 1000.0 << " ms (" << scanLinks
+                  << " links, " << mb / scanTime << " MB/s), " << regexTime / scanTime << "x" << std::endl;
+    }
+    std::cout << "overall speedup: " << totalRegex / totalScan << "x" << std::endl;
+    return 0;
+}
@@ -0,0 +1,273 @@
+#include "crawler.h"
+#include "html_parser.h"
+#include "url.h"
+#include <cmath>
+#include <iostream>
+#include <memory>
+
+Crawler::Crawler(Graph& graph, FetchScheduler& fetcher, ResponseCache* cache)
+    : graph(graph), fetcher(fetcher), cache(cache), rng(std::random_device()()) {}
+
+glm::vec3 Crawler::randomOffset(float radius) {
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    glm::vec3 v(dist(rng), dist(rng), dist(rng));
+    return glm::normalize(v) * radius;
+}
+
+int Crawler::addSeed(std::string_view typed, const glm::vec3& pos, FetchPriority priority) {
+    // Same canonical form as extracted links, so the node matches later links to it
+    std::string url = canonicalUrl(typed);
+    if (url.empty()) url = canonicalUrl("https://" + std::string(typed));
+    if (url.empty()) {
+        std::cout << "Invalid URL: " << typed << "\n";
+        return -1;
+    }
+
+    int existing = graph.findNodeByUrl(url);
+    if (existing >= 0) {
+        if (verbose) std::cout << "Already in graph: " << url << "\n";
+        return existing;
+    }
+    int nodeIdx = graph.addNode(url, pos);
+    if (depth.size() < graph.nodes.size()) depth.resize(graph.nodes.size());
+    depth[nodeIdx] = 0;
+    fetch(nodeIdx, priority);
+    if (verbose) std::cout << "Added node: " << url << "\n";
+    return nodeIdx;
+}
+
+void Crawler::applyLinks(int nodeIdx, const std::vector<std::string>& links, int httpCode) {
+    Node& node = graph.nodes[nodeIdx];
+    node.status = NodeStatus::Success;
+    node.httpCode = httpCode;
+    node.links.clear();
+    node.links.reserve(links.size());
+    for (const auto& link : links) node.links.push_back(graph.urls.intern(link));
+    float logSize = std::log(1.0f + node.links.size());
+    node.targetSize = 0.4f + 0.25f * logSize * (1.0f + logSize * 0.1f);
+}
+
+// Per-request state filled in on the network thread
+struct FetchedPage {
+    LinkExtractor extractor;
+    CacheEntry cached;                  // Entry found in the cache, if any
+    std::vector<std::string> links;     // Final, deduplicated and capped
+    bool fromCache = false;             // Links came from cached, fresh or revalidated
+
+    FetchedPage(std::string_view url, size_t maxLinks) : extractor(std::string(url), maxLinks) {}
+};
+
+void Crawler::fetch(int nodeIdx, FetchPriority priority) {
+    if (!graph.alive(nodeIdx)) return;
+    Node& node = graph.nodes[nodeIdx];
+    if (node.fetching) return;
+
+    // Interned strings never move, so the view is safe to hand to the network thread
+    std::string_view url = graph.url(nodeIdx);
+    auto page = std::make_shared<FetchedPage>(url, maxLinksPerPage);
+    node.fetching = true;
+    if (!cache) {
+        request(nodeIdx, priority, page);
+        return;
+    }
+
+    // The cache is read on the network thread, ahead of the scheduler: fresh
+    // entries are not charged to their host, stale ones are revalidated
+    lookups++;
+    NodeHandle handle = graph.handle(nodeIdx);
+    fetcher.runAsync([page, url, cache = cache] {
+        if (cache->lookup(std::string(url), page->cached) && page->cached.fresh(time(nullptr))) {
+            page->links = std::move(page->cached.links);
+            page->fromCache = true;
+        }
+    }, [this, handle, priority, url, page] {
+        lookups--;
+        int nodeIdx = graph.resolve(handle);
+        if (nodeIdx < 0) return;
+        if (!page->fromCache) {
+            request(nodeIdx, priority, page);
+            return;
+        }
+        Node& node = graph.nodes[nodeIdx];
+        node.fetching = false;
+        applyLinks(nodeIdx, page->links, page->cached.statusCode);
+        if (verbose) std::cout << "Cached " << url << " - " << node.links.size() << " links\n";
+        finished(nodeIdx);
+    });
+}
+
+void Crawler::request(int nodeIdx, FetchPriority priority, std::shared_ptr<FetchedPage> page) {
+    std::string_view url = graph.url(nodeIdx);
+    FetchOptions options;
+    options.priority = priority;
+    if (!page->cached.url.empty()) options.headers = ResponseCache::validators(page->cached);
+
+    // Links are pulled out of the body as it downloads, and the cache is
+    // written, all on the network thread; the body itself is never kept
+    options.onBody = [page](const char* data, size_t len) { page->extractor.feed(data, len); };
+    options.onComplete = [page, url, cache = cache](HttpResponse& resp) {
+        long maxAge = cache ? cache->maxAgeFor(resp.header("cache-control")) : -1;
+        if (resp.statusCode == 304 && !page->cached.url.empty()) {
+            // Not modified: the cached links are still good
+            page->cached.fetchedAt = time(nullptr);
+            page->cached.maxAge = std::max(maxAge, 0L);
+            cache->store(page->cached);
+            page->links = std::move(page->cached.links);
+            page->fromCache = true;
+            return;
+        }
+        if (!resp.error.empty() || resp.statusCode >= 400) return;
+
+        page->extractor.finish();
+        page->links = page->extractor.takeLinks();
+        if (maxAge >= 0) {
+            CacheEntry entry;
+            entry.url = url;
+            entry.statusCode = resp.statusCode;
+            entry.fetchedAt = time(nullptr);
+            entry.maxAge = maxAge;
+            entry.etag = resp.header("etag");
+            entry.lastModified = resp.header("last-modified");
+            entry.links = page->links;
+            cache->store(entry);
+        }
+    };
+
+    NodeHandle handle = graph.handle(nodeIdx);
+    fetcher.fetchAsync(std::string(url), [this, handle, url, page](HttpResponse resp) {
+        // Node might have been deleted (or the graph cleared) while in flight
+        int nodeIdx = graph.resolve(handle);
+        if (nodeIdx < 0) return;
+
+        Node& node = graph.nodes[nodeIdx];
+        node.fetching = false;
+
+        if (page->fromCache) {
+            applyLinks(nodeIdx, page->links, page->cached.statusCode);
+            if (verbose) std::cout << "Revalidated " << url << " - " << node.links.size() << " links\n";
+        } else if (!resp.error.empty() || resp.statusCode >= 400) {
+            node.status = NodeStatus::Error;
+            node.httpCode = resp.statusCode > 0 ? resp.statusCode : -1;
+            if (verbose) std::cout << "Error fetching " << url << ": " << node.httpCode << "\n";
+        } else {
+            applyLinks(nodeIdx, page->links, resp.statusCode);
+            if (verbose) std::cout << "Fetched " << url << " - " << node.links.size() << " links\n";
+        }
+        finished(nodeIdx);
+    }, std::move(options));
+}
+
+void Crawler::finished(int nodeIdx) {
+    graph.fetched(nodeIdx);
+    if (autoExpand && graph.nodes[nodeIdx].status == NodeStatus::Success &&
+        (size_t)nodeIdx < depth.size() && depth[nodeIdx] < maxDepth) {
+        activate(nodeIdx, FetchPriority::Bulk);
+    }
+}
+
+void Crawler::activate(int nodeIdx, FetchPriority priority) {
+    if (!graph.alive(nodeIdx)) return;
+    Node& node = graph.nodes[nodeIdx];
+
+    if (node.status == NodeStatus::Pending) {
+        // Still fetching, do nothing
+        return;
+    }
+
+    if (node.status == NodeStatus::Error) {
+        // Retry failed request
+        node.status = NodeStatus::Pending;
+        node.fetching = false;
+        fetch(nodeIdx, priority);
+        if (verbose) std::cout << "Retrying: " << graph.url(nodeIdx) << "\n";
+        return;
+    }
+
+    // Success - expand if not already
+    if (node.expanded) return;
+    graph.setExpanded(nodeIdx);
+
+    // Queue all links for gradual expansion (per-node queue)
+    auto& pending = pendingLinks[nodeIdx];
+    pending.parent = graph.handle(nodeIdx);
+    pending.priority = priority;
+    for (UrlId link : node.links) {
+        pending.links.push(link);
+    }
+    if (verbose) std::cout << "Queued: " << graph.url(nodeIdx) << " (" << node.links.size() << " links)\n";
+}
+
+void Crawler::spawnPending(Clock::time_point deadline) {
+    if (pendingLinks.empty()) return;
+
+    // Process one link from each active node queue (copy keys to avoid iterator issues)
+    std::vector<int> parentKeys;
+    for (auto& [k, v] : pendingLinks) {
+        parentKeys.push_back(k);
+    }
+
+    size_t parentCount = parentKeys.size();
+    for (size_t n = 0; n < parentCount; n++) {
+        if (n > 0 && Clock::now() >= deadline) {
+            pendingCursor += n;
+            return;
+        }
+        int parentIdx = parentKeys[(pendingCursor + n) % parentCount];
+        auto it = pendingLinks.find(parentIdx);
+        if (it == pendingLinks.end()) continue;
+
+        auto& queue = it->second.links;
+        if (queue.empty()) {
+            pendingLinks.erase(parentIdx);
+            continue;
+        }
+
+        // Validate parent still exists (its slot may have been reused)
+        if (graph.resolve(it->second.parent) != parentIdx) {
+            pendingLinks.erase(parentIdx);
+            continue;
+        }
+
+        UrlId url = queue.front();
+        queue.pop();
+        FetchPriority priority = it->second.priority;
+
+        if (queue.empty()) {
+            pendingLinks.erase(parentIdx);
+        }
+
+        // Check if this URL already exists as a node
+        int existingIdx = graph.findNodeByUrl(url);
+        if (existingIdx >= 0) {
+            // Link to existing node
+            graph.addEdge(parentIdx, existingIdx);
+        } else if (!maxNodes || (size_t)graph.nodeCount() < maxNodes) {
+            // Create new node - get position before modifying graph
+            glm::vec3 parentPos = graph.position(parentIdx);
+            glm::vec3 pos = parentPos + randomOffset(6.0f);
+            int childIdx = graph.addNode(url, pos);
+            graph.addEdge(parentIdx, childIdx);
+            if (depth.size() < graph.nodes.size()) depth.resize(graph.nodes.size());
+            depth[childIdx] = depth[parentIdx] + 1;
+            fetch(childIdx, priority);
+        }
+    }
+}
+
+void Crawler::fetchPendingNodes() {
+    for (size_t i = 0; i < graph.nodes.size(); i++) {
+        if (graph.alive(i) && graph.nodes[i].status == NodeStatus::Pending) fetch(i);
+    }
+}
+
+size_t Crawler::pendingCount() const {
+    size_t count = 0;
+    for (const auto& [k, pending] : pendingLinks) {
+        count += pending.links.size();
+    }
+    return count;
+}
+
+bool Crawler::idle() const {
+    return pendingLinks.empty() && lookups == 0 && fetcher.queuedCount() == 0 && fetcher.inFlightCount() == 0;
+}
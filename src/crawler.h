@@ -0,0 +1,76 @@
+#pragma once
+#include "graph.h"
+#include "fetch_scheduler.h"
+#include "response_cache.h"
+#include <chrono>
+#include <memory>
+#include <queue>
+#include <random>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct FetchedPage;
+
+// Grows a Graph from the web: fetches nodes through the FetchScheduler,
+// stores their link lists and spawns linked pages as child nodes. Used by
+// both the interactive viewer and headless crawls. Main thread only,
+// apart from the per-request hooks it hands to the network thread.
+class Crawler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // cache may be null; it must outlive the HttpClient behind fetcher
+    Crawler(Graph& graph, FetchScheduler& fetcher, ResponseCache* cache = nullptr);
+
+    size_t maxLinksPerPage = 200;
+    bool verbose = true;     // Log every fetch and expansion
+
+    // Headless crawls: pages shallower than maxDepth are expanded as soon as
+    // they are fetched, and no new nodes are spawned once the graph holds
+    // maxNodes (0 = no limit)
+    bool autoExpand = false;
+    int maxDepth = 0;
+    size_t maxNodes = 0;
+
+    // Adds url as a root node, or finds the existing node for it, and fetches it
+    int addSeed(std::string_view url, const glm::vec3& pos, FetchPriority priority);
+    void fetch(int nodeIdx, FetchPriority priority = FetchPriority::Bulk);
+    // Queues the links of a fetched node for spawning, or retries a failed one
+    void activate(int nodeIdx, FetchPriority priority);
+    // Spawns one queued link for each expanding parent, starting where the
+    // last call ran out of time. At least one parent is served per call.
+    void spawnPending(Clock::time_point deadline = Clock::time_point::max());
+
+    // Fetches nodes left pending, e.g. after loading a snapshot
+    void fetchPendingNodes();
+    void forget(int nodeIdx) { pendingLinks.erase(nodeIdx); }
+    void clearPending() { pendingLinks.clear(); }
+    bool hasPendingLinks() const { return !pendingLinks.empty(); }
+    size_t pendingCount() const;
+    // Nothing queued, in flight or waiting to be spawned
+    bool idle() const;
+
+private:
+    // Links of one expanding node, spawned a few at a time
+    struct PendingLinks {
+        NodeHandle parent;
+        FetchPriority priority = FetchPriority::Bulk; // Inherited by the spawned children
+        std::queue<UrlId> links;
+    };
+
+    Graph& graph;
+    FetchScheduler& fetcher;
+    ResponseCache* cache;
+    std::unordered_map<int, PendingLinks> pendingLinks;
+    size_t pendingCursor = 0;
+    std::vector<int> depth; // Hops from a seed, by slot
+    int lookups = 0;        // Cache lookups still on the network thread
+    std::mt19937 rng;
+
+    // Sends a fetch through the scheduler, revalidating page->cached if set
+    void request(int nodeIdx, FetchPriority priority, std::shared_ptr<FetchedPage> page);
+    void applyLinks(int nodeIdx, const std::vector<std::string>& links, int httpCode);
+    void finished(int nodeIdx);
+    glm::vec3 randomOffset(float radius);
+};
@@ -0,0 +1,171 @@
+#include "fetch_scheduler.h"
+#include <curl/curl.h>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <ctime>
+#include <iostream>
+
+// Throttled hosts drop to this fraction of their rate and recover additively
+static const float throttleRateFactor = 0.5f;
+static const float minRate = 0.25f;
+static const float rateRecovery = 0.1f;
+static const float maxBackoffSeconds = 120.0f;
+
+FetchScheduler::FetchScheduler(HttpClient& http) : http(http) {}
+
+std::string FetchScheduler::hostOf(const std::string& url) {
+    size_t start = url.find("://");
+    start = start == std::string::npos ? 0 : start + 3;
+    size_t end = url.find_first_of("/?#", start);
+    std::string host = url.substr(start, end == std::string::npos ? std::string::npos : end - start);
+    size_t at = host.rfind('@');
+    if (at != std::string::npos) host.erase(0, at + 1);
+    std::transform(host.begin(), host.end(), host.begin(), ::tolower);
+    return host;
+}
+
+FetchScheduler::Host& FetchScheduler::hostFor(const std::string& name) {
+    auto it = hosts.find(name);
+    if (it != hosts.end()) return it->second;
+
+    Host& host = hosts[name];
+    host.tokens = burst;
+    host.rate = requestsPerSecond;
+    host.refilled = Clock::now();
+    return host;
+}
+
+void FetchScheduler::fetchAsync(const std::string& url, std::function<void(HttpResponse)> callback, FetchOptions options) {
+    std::string name = hostOf(url);
+    Host& host = hostFor(name);
+    if (host.depth() == 0) ring.push_back(name);
+
+    Request req{url, std::move(callback), std::move(options)};
+    if (req.options.priority == FetchPriority::Interactive) {
+        host.interactive.push_back(std::move(req));
+    } else {
+        host.bulk.push_back(std::move(req));
+    }
+    queued++;
+}
+
+void FetchScheduler::refill(Host& host, Clock::time_point now) {
+    float elapsed = std::chrono::duration<float>(now - host.refilled).count();
+    host.tokens = std::min(burst, host.tokens + elapsed * host.rate);
+    host.refilled = now;
+}
+
+void FetchScheduler::dispatch(const std::string& name, Host& host, Request&& req) {
+    host.tokens -= 1.0f;
+    host.inFlight++;
+    inFlight++;
+    req.attempts++;
+
+    std::string url = req.url;
+    FetchOptions options = req.options; // Kept on the request in case it is retried
+    // The scheduler outlives every delivery: HttpClient only calls back from update()
+    http.fetchAsync(url, [this, name, req = std::move(req)](HttpResponse resp) mutable {
+        onResponse(name, std::move(req), std::move(resp));
+    }, std::move(options));
+}
+
+// Seconds from a Retry-After value (delay-seconds or HTTP-date), or -1
+static float parseRetryAfter(const std::string& value) {
+    if (value.empty()) return -1.0f;
+    if (std::all_of(value.begin(), value.end(), [](char c) { return std::isdigit((unsigned char)c); })) {
+        unsigned long long seconds = 0;
+        auto result = std::from_chars(value.data(), value.data() + value.size(), seconds);
+        if (result.ec == std::errc::result_out_of_range || seconds > maxBackoffSeconds) return maxBackoffSeconds;
+        return (float)seconds;
+    }
+    time_t when = curl_getdate(value.c_str(), nullptr);
+    if (when < 0) return -1.0f;
+    return std::max(0.0f, (float)difftime(when, time(nullptr)));
+}
+
+void FetchScheduler::onResponse(const std::string& name, Request&& req, HttpResponse&& resp) {
+    Host& host = hosts[name];
+    host.inFlight--;
+    inFlight--;
+
+    bool throttled = resp.statusCode == 429 || resp.statusCode == 503;
+    if (!throttled) {
+        host.throttleStreak = 0;
+        host.rate = std::min(requestsPerSecond, host.rate + rateRecovery);
+        req.callback(std::move(resp));
+        return;
+    }
+
+    // Back off: honour Retry-After when given, otherwise grow exponentially
+    host.throttleStreak++;
+    host.rate = std::max(minRate, host.rate * throttleRateFactor);
+    host.tokens = 0.0f;
+    float delay = parseRetryAfter(resp.header("retry-after"));
+    if (delay < 0.0f) delay = (float)(1 << std::min(host.throttleStreak, 7));
+    delay = std::min(delay, maxBackoffSeconds);
+    host.blockedUntil = std::max(host.blockedUntil, Clock::now() + std::chrono::milliseconds((int)(delay * 1000.0f)));
+    if (verbose) std::cout << "Throttled by " << name << " (" << resp.statusCode << "), backing off " << delay << "s\n";
+
+    if (req.attempts > maxRetries) {
+        req.callback(std::move(resp));
+        return;
+    }
+    if (host.depth() == 0) ring.push_back(name);
+    if (req.options.priority == FetchPriority::Interactive) {
+        host.interactive.push_front(std::move(req));
+    } else {
+        host.bulk.push_front(std::move(req));
+    }
+    queued++;
+}
+
+bool FetchScheduler::dispatchPass(FetchPriority priority, Clock::time_point now) {
+    bool sent = false;
+    // Each host in the ring is visited once, including those erased on the way
+    for (size_t remaining = ring.size(); remaining > 0 && inFlight < maxInFlight; remaining--) {
+        if (cursor >= ring.size()) cursor = 0;
+        const std::string& name = ring[cursor];
+        Host& host = hosts[name];
+        auto& queue = priority == FetchPriority::Interactive ? host.interactive : host.bulk;
+
+        refill(host, now);
+        if (!queue.empty() && now >= host.blockedUntil && host.inFlight < maxPerHost && host.tokens >= 1.0f) {
+            Request req = std::move(queue.front());
+            queue.pop_front();
+            queued--;
+            dispatch(name, host, std::move(req));
+            sent = true;
+        }
+
+        if (host.depth() == 0) {
+            ring.erase(ring.begin() + cursor);
+        } else {
+            cursor++;
+        }
+    }
+    return sent;
+}
+
+void FetchScheduler::update(Clock::time_point deadline) {
+    http.update(deadline);
+
+    // One request per host per round keeps a single large site from starving the rest.
+    // Interactive requests go first but still respect each host's limits.
+    auto now = Clock::now();
+    while (dispatchPass(FetchPriority::Interactive, now)) {}
+    while (dispatchPass(FetchPriority::Bulk, now)) {}
+}
+
+std::vector<std::pair<std::string, int>> FetchScheduler::hostDepths(size_t maxHosts) const {
+    std::vector<std::pair<std::string, int>> depths;
+    for (const auto& name : ring) {
+        auto it = hosts.find(name);
+        if (it != hosts.end()) depths.push_back({name, (int)it->second.depth()});
+    }
+    size_t keep = std::min(maxHosts, depths.size());
+    std::partial_sort(depths.begin(), depths.begin() + keep, depths.end(),
+                      [](const auto& a, const auto& b) { return a.second > b.second; });
+    depths.resize(keep);
+    return depths;
+}
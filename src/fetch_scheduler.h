@@ -0,0 +1,73 @@
+#pragma once
+#include "http_client.h"
+#include <chrono>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Sits in front of HttpClient and decides when each request may go out.
+// Requests are queued per host, each host has a token bucket, hosts are
+// served round-robin, and 429/503 responses make the host back off.
+// Everything here runs on the main thread.
+class FetchScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit FetchScheduler(HttpClient& http);
+
+    float requestsPerSecond = 8.0f; // Steady per-host rate
+    float burst = 8.0f;             // Bucket capacity
+    int maxPerHost = 6;             // Requests in flight to one host
+    int maxInFlight = 64;           // Requests in flight overall
+    int maxRetries = 3;             // Throttled responses retried before giving up
+    bool verbose = true;            // Log every backoff
+
+    void fetchAsync(const std::string& url, std::function<void(HttpResponse)> callback, FetchOptions options = {});
+    // Work for the network thread that sends no request, so no host is charged for it
+    void runAsync(std::function<void()> work, std::function<void()> callback) {
+        http.runAsync(std::move(work), std::move(callback));
+    }
+    // Deliver completions (until the deadline) and dispatch whatever the limits allow
+    void update(Clock::time_point deadline = Clock::time_point::max());
+
+    size_t queuedCount() const { return queued; }
+    int inFlightCount() const { return inFlight; }
+    // Hosts with queued requests, deepest first
+    std::vector<std::pair<std::string, int>> hostDepths(size_t maxHosts) const;
+
+    static std::string hostOf(const std::string& url);
+
+private:
+    struct Request {
+        std::string url;
+        std::function<void(HttpResponse)> callback;
+        FetchOptions options;
+        int attempts = 0;
+    };
+    struct Host {
+        std::deque<Request> interactive, bulk;
+        float tokens = 0.0f;
+        float rate = 0.0f;           // Current rate, lowered while throttled
+        Clock::time_point refilled;
+        Clock::time_point blockedUntil;
+        int inFlight = 0;
+        int throttleStreak = 0;      // Consecutive 429/503 responses
+
+        size_t depth() const { return interactive.size() + bulk.size(); }
+    };
+
+    HttpClient& http;
+    std::unordered_map<std::string, Host> hosts;
+    std::vector<std::string> ring; // Hosts with queued requests, in round-robin order
+    size_t cursor = 0;
+    size_t queued = 0;
+    int inFlight = 0;
+
+    Host& hostFor(const std::string& name);
+    void refill(Host& host, Clock::time_point now);
+    void dispatch(const std::string& name, Host& host, Request&& req);
+    void onResponse(const std::string& name, Request&& req, HttpResponse&& resp);
+    bool dispatchPass(FetchPriority priority, Clock::time_point now);
+};
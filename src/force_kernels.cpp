@@ -0,0 +1,246 @@
+#include "force_kernels.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FORCE_KERNELS_X86 1
+#endif
+
+// Shared by every variant for the remainder lanes so results stay identical
+static inline void repulsePair(const float* x, const float* y, const float* z, const float* size,
+                               float* ax, float* ay, float* az, int j,
+                               float xi, float yi, float zi, float halfScaleSi, float halfScale,
+                               float cutoff2, float& sx, float& sy, float& sz) {
+    float dx = xi - x[j], dy = yi - y[j], dz = zi - z[j];
+    float d2 = dx * dx + dy * dy + dz * dz;
+    if (d2 > cutoff2) return;
+    float dist = std::max(std::sqrt(d2), 0.5f); // Soft minimum
+    float s = (halfScaleSi + halfScale * size[j]) / ((dist * dist + 1.0f) * dist);
+    float fx = dx * s, fy = dy * s, fz = dz * s;
+    sx += fx; sy += fy; sz += fz;
+    ax[j] -= fx; ay[j] -= fy; az[j] -= fz;
+}
+
+static void repulseRowScalar(const float* x, const float* y, const float* z, const float* size,
+                             float* ax, float* ay, float* az, int i, int jBegin, int jEnd,
+                             float strengthScale, float cutoff) {
+    float halfScale = strengthScale * 0.5f;
+    float sx = 0.0f, sy = 0.0f, sz = 0.0f;
+    for (int j = jBegin; j < jEnd; j++) {
+        repulsePair(x, y, z, size, ax, ay, az, j, x[i], y[i], z[i], halfScale * size[i], halfScale,
+                    cutoff * cutoff, sx, sy, sz);
+    }
+    ax[i] += sx; ay[i] += sy; az[i] += sz;
+}
+
+static void integrateScalar(float* x, float* y, float* z, float* vx, float* vy, float* vz,
+                            int begin, int end, float drag, float maxSpeed, float dt) {
+    float keep = 1.0f - drag * dt;
+    for (int i = begin; i < end; i++) {
+        // Drag force opposes velocity, proportional to speed
+        float px = vx[i] * keep, py = vy[i] * keep, pz = vz[i] * keep;
+        float speed = std::sqrt(px * px + py * py + pz * pz);
+        if (speed > maxSpeed) {
+            float k = maxSpeed / speed;
+            px *= k; py *= k; pz *= k;
+        }
+        vx[i] = px; vy[i] = py; vz[i] = pz;
+        x[i] += px * dt; y[i] += py * dt; z[i] += pz * dt;
+    }
+}
+
+#ifdef FORCE_KERNELS_X86
+
+static void repulseRowSSE(const float* x, const float* y, const float* z, const float* size,
+                          float* ax, float* ay, float* az, int i, int jBegin, int jEnd,
+                          float strengthScale, float cutoff) {
+    float halfScale = strengthScale * 0.5f;
+    float cutoff2 = cutoff * cutoff;
+    __m128 xi = _mm_set1_ps(x[i]), yi = _mm_set1_ps(y[i]), zi = _mm_set1_ps(z[i]);
+    __m128 hsi = _mm_set1_ps(halfScale * size[i]), hs = _mm_set1_ps(halfScale);
+    __m128 cut = _mm_set1_ps(cutoff2), minDist = _mm_set1_ps(0.5f), one = _mm_set1_ps(1.0f);
+    __m128 sx = _mm_setzero_ps(), sy = _mm_setzero_ps(), sz = _mm_setzero_ps();
+
+    int j = jBegin;
+    for (; j + 4 <= jEnd; j += 4) {
+        __m128 dx = _mm_sub_ps(xi, _mm_loadu_ps(x + j));
+        __m128 dy = _mm_sub_ps(yi, _mm_loadu_ps(y + j));
+        __m128 dz = _mm_sub_ps(zi, _mm_loadu_ps(z + j));
+        __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        __m128 mask = _mm_cmple_ps(d2, cut);
+        if (_mm_movemask_ps(mask) == 0) continue;
+
+        __m128 dist = _mm_max_ps(_mm_sqrt_ps(d2), minDist);
+        __m128 denom = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(dist, dist), one), dist);
+        __m128 s = _mm_div_ps(_mm_add_ps(hsi, _mm_mul_ps(hs, _mm_loadu_ps(size + j))), denom);
+        s = _mm_and_ps(s, mask);
+
+        __m128 fx = _mm_mul_ps(dx, s), fy = _mm_mul_ps(dy, s), fz = _mm_mul_ps(dz, s);
+        sx = _mm_add_ps(sx, fx);
+        sy = _mm_add_ps(sy, fy);
+        sz = _mm_add_ps(sz, fz);
+        _mm_storeu_ps(ax + j, _mm_sub_ps(_mm_loadu_ps(ax + j), fx));
+        _mm_storeu_ps(ay + j, _mm_sub_ps(_mm_loadu_ps(ay + j), fy));
+        _mm_storeu_ps(az + j, _mm_sub_ps(_mm_loadu_ps(az + j), fz));
+    }
+
+    alignas(16) float lanes[3][4];
+    _mm_store_ps(lanes[0], sx);
+    _mm_store_ps(lanes[1], sy);
+    _mm_store_ps(lanes[2], sz);
+    float tx = lanes[0][0] + lanes[0][1] + lanes[0][2] + lanes[0][3];
+    float ty = lanes[1][0] + lanes[1][1] + lanes[1][2] + lanes[1][3];
+    float tz = lanes[2][0] + lanes[2][1] + lanes[2][2] + lanes[2][3];
+    for (; j < jEnd; j++) {
+        repulsePair(x, y, z, size, ax, ay, az, j, x[i], y[i], z[i], halfScale * size[i], halfScale,
+                    cutoff2, tx, ty, tz);
+    }
+    ax[i] += tx; ay[i] += ty; az[i] += tz;
+}
+
+static void integrateSSE(float* x, float* y, float* z, float* vx, float* vy, float* vz,
+                         int begin, int end, float drag, float maxSpeed, float dt) {
+    __m128 keep = _mm_set1_ps(1.0f - drag * dt), step = _mm_set1_ps(dt);
+    __m128 limit = _mm_set1_ps(maxSpeed), one = _mm_set1_ps(1.0f);
+    int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 px = _mm_mul_ps(_mm_loadu_ps(vx + i), keep);
+        __m128 py = _mm_mul_ps(_mm_loadu_ps(vy + i), keep);
+        __m128 pz = _mm_mul_ps(_mm_loadu_ps(vz + i), keep);
+        __m128 speed = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px, px), _mm_mul_ps(py, py)), _mm_mul_ps(pz, pz)));
+        // Only lanes above the limit get rescaled (avoids 0/0 for resting nodes)
+        __m128 over = _mm_cmpgt_ps(speed, limit);
+        __m128 k = _mm_or_ps(_mm_and_ps(over, _mm_div_ps(limit, speed)), _mm_andnot_ps(over, one));
+        px = _mm_mul_ps(px, k);
+        py = _mm_mul_ps(py, k);
+        pz = _mm_mul_ps(pz, k);
+        _mm_storeu_ps(vx + i, px);
+        _mm_storeu_ps(vy + i, py);
+        _mm_storeu_ps(vz + i, pz);
+        _mm_storeu_ps(x + i, _mm_add_ps(_mm_loadu_ps(x + i), _mm_mul_ps(px, step)));
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(py, step)));
+        _mm_storeu_ps(z + i, _mm_add_ps(_mm_loadu_ps(z + i), _mm_mul_ps(pz, step)));
+    }
+    integrateScalar(x, y, z, vx, vy, vz, i, end, drag, maxSpeed, dt);
+}
+
+__attribute__((target("avx2")))
+static void repulseRowAVX2(const float* x, const float* y, const float* z, const float* size,
+                           float* ax, float* ay, float* az, int i, int jBegin, int jEnd,
+                           float strengthScale, float cutoff) {
+    float halfScale = strengthScale * 0.5f;
+    float cutoff2 = cutoff * cutoff;
+    __m256 xi = _mm256_set1_ps(x[i]), yi = _mm256_set1_ps(y[i]), zi = _mm256_set1_ps(z[i]);
+    __m256 hsi = _mm256_set1_ps(halfScale * size[i]), hs = _mm256_set1_ps(halfScale);
+    __m256 cut = _mm256_set1_ps(cutoff2), minDist = _mm256_set1_ps(0.5f), one = _mm256_set1_ps(1.0f);
+    __m256 sx = _mm256_setzero_ps(), sy = _mm256_setzero_ps(), sz = _mm256_setzero_ps();
+
+    int j = jBegin;
+    for (; j + 8 <= jEnd; j += 8) {
+        __m256 dx = _mm256_sub_ps(xi, _mm256_loadu_ps(x + j));
+        __m256 dy = _mm256_sub_ps(yi, _mm256_loadu_ps(y + j));
+        __m256 dz = _mm256_sub_ps(zi, _mm256_loadu_ps(z + j));
+        __m256 d2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+        __m256 mask = _mm256_cmp_ps(d2, cut, _CMP_LE_OQ);
+        if (_mm256_movemask_ps(mask) == 0) continue;
+
+        __m256 dist = _mm256_max_ps(_mm256_sqrt_ps(d2), minDist);
+        __m256 denom = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(dist, dist), one), dist);
+        __m256 s = _mm256_div_ps(_mm256_add_ps(hsi, _mm256_mul_ps(hs, _mm256_loadu_ps(size + j))), denom);
+        s = _mm256_and_ps(s, mask);
+
+        __m256 fx = _mm256_mul_ps(dx, s), fy = _mm256_mul_ps(dy, s), fz = _mm256_mul_ps(dz, s);
+        sx = _mm256_add_ps(sx, fx);
+        sy = _mm256_add_ps(sy, fy);
+        sz = _mm256_add_ps(sz, fz);
+        _mm256_storeu_ps(ax + j, _mm256_sub_ps(_mm256_loadu_ps(ax + j), fx));
+        _mm256_storeu_ps(ay + j, _mm256_sub_ps(_mm256_loadu_ps(ay + j), fy));
+        _mm256_storeu_ps(az + j, _mm256_sub_ps(_mm256_loadu_ps(az + j), fz));
+    }
+
+    alignas(32) float lanes[3][8];
+    _mm256_store_ps(lanes[0], sx);
+    _mm256_store_ps(lanes[1], sy);
+    _mm256_store_ps(lanes[2], sz);
+    float tx = 0.0f, ty = 0.0f, tz = 0.0f;
+    for (int k = 0; k < 8; k++) {
+        tx += lanes[0][k];
+        ty += lanes[1][k];
+        tz += lanes[2][k];
+    }
+    for (; j < jEnd; j++) {
+        repulsePair(x, y, z, size, ax, ay, az, j, x[i], y[i], z[i], halfScale * size[i], halfScale,
+                    cutoff2, tx, ty, tz);
+    }
+    ax[i] += tx; ay[i] += ty; az[i] += tz;
+}
+
+__attribute__((target("avx2")))
+static void integrateAVX2(float* x, float* y, float* z, float* vx, float* vy, float* vz,
+                          int begin, int end, float drag, float maxSpeed, float dt) {
+    __m256 keep = _mm256_set1_ps(1.0f - drag * dt), step = _mm256_set1_ps(dt);
+    __m256 limit = _mm256_set1_ps(maxSpeed), one = _mm256_set1_ps(1.0f);
+    int i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 px = _mm256_mul_ps(_mm256_loadu_ps(vx + i), keep);
+        __m256 py = _mm256_mul_ps(_mm256_loadu_ps(vy + i), keep);
+        __m256 pz = _mm256_mul_ps(_mm256_loadu_ps(vz + i), keep);
+        __m256 speed = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px, px), _mm256_mul_ps(py, py)), _mm256_mul_ps(pz, pz)));
+        __m256 over = _mm256_cmp_ps(speed, limit, _CMP_GT_OQ);
+        __m256 k = _mm256_blendv_ps(one, _mm256_div_ps(limit, speed), over);
+        px = _mm256_mul_ps(px, k);
+        py = _mm256_mul_ps(py, k);
+        pz = _mm256_mul_ps(pz, k);
+        _mm256_storeu_ps(vx + i, px);
+        _mm256_storeu_ps(vy + i, py);
+        _mm256_storeu_ps(vz + i, pz);
+        _mm256_storeu_ps(x + i, _mm256_add_ps(_mm256_loadu_ps(x + i), _mm256_mul_ps(px, step)));
+        _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_mul_ps(py, step)));
+        _mm256_storeu_ps(z + i, _mm256_add_ps(_mm256_loadu_ps(z + i), _mm256_mul_ps(pz, step)));
+    }
+    integrateScalar(x, y, z, vx, vy, vz, i, end, drag, maxSpeed, dt);
+}
+
+#endif
+
+struct KernelTable {
+    decltype(&repulseRowScalar) repulse = repulseRowScalar;
+    decltype(&integrateScalar) integrate = integrateScalar;
+    const char* name = "scalar";
+
+    KernelTable() {
+#ifdef FORCE_KERNELS_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            repulse = repulseRowAVX2;
+            integrate = integrateAVX2;
+            name = "avx2";
+        } else if (__builtin_cpu_supports("sse2")) {
+            repulse = repulseRowSSE;
+            integrate = integrateSSE;
+            name = "sse2";
+        }
+#endif
+    }
+};
+
+static const KernelTable& kernels() {
+    static KernelTable table;
+    return table;
+}
+
+void repulseRow(const float* x, const float* y, const float* z, const float* size,
+                float* ax, float* ay, float* az, int i, int jBegin, int jEnd,
+                float strengthScale, float cutoff) {
+    kernels().repulse(x, y, z, size, ax, ay, az, i, jBegin, jEnd, strengthScale, cutoff);
+}
+
+void integrateRange(float* x, float* y, float* z, float* vx, float* vy, float* vz,
+                    int begin, int end, float drag, float maxSpeed, float dt) {
+    kernels().integrate(x, y, z, vx, vy, vz, begin, end, drag, maxSpeed, dt);
+}
+
+const char* forceKernelName() {
+    return kernels().name;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+// Force kernels over structure-of-arrays node state. The widest instruction
+// set the CPU supports (AVX2, SSE2, scalar) is picked once at startup.
+
+// Repulsion of node i against nodes [jBegin, jEnd) with the soft-falloff law
+// used by Physics. Adds the force on i to (ax, ay, az)[i] and subtracts it
+// from every j. strengthScale is repulsion * dt.
+void repulseRow(const float* x, const float* y, const float* z, const float* size,
+                float* ax, float* ay, float* az, int i, int jBegin, int jEnd,
+                float strengthScale, float cutoff);
+
+// Drag, speed clamp and explicit Euler step for nodes [begin, end)
+void integrateRange(float* x, float* y, float* z, float* vx, float* vy, float* vz,
+                    int begin, int end, float drag, float maxSpeed, float dt);
+
+const char* forceKernelName();
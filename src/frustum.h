@@ -0,0 +1,53 @@
+#pragma once
+#include <glm/glm.hpp>
+
+// Convex volume bounded by six planes (xyz = normal pointing inwards,
+// w = offset), used for view culling and volume selection
+struct Frustum {
+    glm::vec4 planes[6];
+
+    // The clip volume of a view-projection matrix
+    explicit Frustum(const glm::mat4& m) {
+        glm::vec4 row[4];
+        for (int r = 0; r < 4; r++) row[r] = glm::vec4(m[0][r], m[1][r], m[2][r], m[3][r]);
+        for (int axis = 0; axis < 3; axis++) {
+            planes[axis * 2] = row[3] + row[axis];
+            planes[axis * 2 + 1] = row[3] - row[axis];
+        }
+        for (auto& p : planes) p /= glm::length(glm::vec3(p));
+    }
+
+    // An axis-aligned box
+    static Frustum box(const glm::vec3& lo, const glm::vec3& hi) {
+        Frustum f(glm::mat4(1.0f));
+        for (int axis = 0; axis < 3; axis++) {
+            glm::vec4 n(0.0f);
+            n[axis] = 1.0f;
+            n.w = -lo[axis];
+            f.planes[axis * 2] = n;
+            n[axis] = -1.0f;
+            n.w = hi[axis];
+            f.planes[axis * 2 + 1] = n;
+        }
+        return f;
+    }
+
+    // -1 when the box is outside, 1 when it is entirely inside, 0 otherwise
+    int classify(const glm::vec3& lo, const glm::vec3& hi) const {
+        int result = 1;
+        for (const auto& p : planes) {
+            glm::vec3 farthest(p.x >= 0 ? hi.x : lo.x, p.y >= 0 ? hi.y : lo.y, p.z >= 0 ? hi.z : lo.z);
+            glm::vec3 nearest(p.x >= 0 ? lo.x : hi.x, p.y >= 0 ? lo.y : hi.y, p.z >= 0 ? lo.z : hi.z);
+            if (glm::dot(glm::vec3(p), farthest) + p.w < 0) return -1;
+            if (glm::dot(glm::vec3(p), nearest) + p.w < 0) result = 0;
+        }
+        return result;
+    }
+
+    bool sphere(const glm::vec3& c, float radius) const {
+        for (const auto& p : planes) {
+            if (glm::dot(glm::vec3(p), c) + p.w < -radius) return false;
+        }
+        return true;
+    }
+};
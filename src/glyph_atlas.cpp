@@ -0,0 +1,178 @@
+#include "glyph_atlas.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+static const int glyphPadding = 1; // Keeps linear filtering from bleeding between neighbours
+
+// Decodes one UTF-8 sequence at text[i] and advances i; malformed bytes become U+FFFD
+static uint32_t nextCodepoint(std::string_view text, size_t& i) {
+    uint8_t c = text[i++];
+    if (c < 0x80) return c;
+    int extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : -1;
+    if (extra < 0 || i + extra > text.size()) return 0xFFFD;
+    uint32_t cp = c & (0x3F >> extra);
+    for (int k = 0; k < extra; k++) {
+        uint8_t cont = text[i];
+        if ((cont & 0xC0) != 0x80) return 0xFFFD;
+        cp = (cp << 6) | (cont & 0x3F);
+        i++;
+    }
+    return cp;
+}
+
+static size_t encodeUtf8(uint32_t cp, char* out) {
+    if (cp < 0x80) { out[0] = cp; return 1; }
+    if (cp < 0x800) { out[0] = 0xC0 | (cp >> 6); out[1] = 0x80 | (cp & 0x3F); return 2; }
+    if (cp < 0x10000) {
+        out[0] = 0xE0 | (cp >> 12); out[1] = 0x80 | ((cp >> 6) & 0x3F); out[2] = 0x80 | (cp & 0x3F);
+        return 3;
+    }
+    out[0] = 0xF0 | (cp >> 18); out[1] = 0x80 | ((cp >> 12) & 0x3F);
+    out[2] = 0x80 | ((cp >> 6) & 0x3F); out[3] = 0x80 | (cp & 0x3F);
+    return 4;
+}
+
+bool GlyphAtlas::init(TTF_Font* f) {
+    font = f;
+    if (!font) return false;
+    height = TTF_FontHeight(font);
+
+    pixels.assign((size_t)atlasW * atlasH, 0);
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlasW, atlasH, 0, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // Printable ASCII up front so the first frames don't stall on rasterizing
+    for (uint32_t c = 32; c < 127; c++) glyph(c);
+    return true;
+}
+
+void GlyphAtlas::shutdown() {
+    if (tex) glDeleteTextures(1, &tex);
+    tex = 0;
+    font = nullptr;
+    others.clear();
+    std::memset(asciiLoaded, 0, sizeof(asciiLoaded));
+}
+
+const GlyphAtlas::Glyph& GlyphAtlas::glyph(uint32_t codepoint) {
+    if (codepoint < 128) {
+        if (!asciiLoaded[codepoint]) {
+            ascii[codepoint] = rasterize(codepoint);
+            asciiLoaded[codepoint] = true;
+        }
+        return ascii[codepoint];
+    }
+    auto it = others.find(codepoint);
+    if (it == others.end()) it = others.emplace(codepoint, rasterize(codepoint)).first;
+    return it->second;
+}
+
+GlyphAtlas::Glyph GlyphAtlas::rasterize(uint32_t codepoint) {
+    Glyph g;
+    if (!font) return g;
+
+    // Rendering the codepoint as a one-character string gives a box the
+    // full line height, so every glyph shares the same baseline
+    char utf8[5] = {};
+    encodeUtf8(codepoint, utf8);
+    SDL_Color white = {255, 255, 255, 255};
+    SDL_Surface* surface = TTF_RenderUTF8_Blended(font, utf8, white);
+    if (!surface) return g;
+    SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(surface);
+    if (!converted) return g;
+
+    int advance = 0;
+    if (codepoint > 0xFFFF || TTF_GlyphMetrics(font, (Uint16)codepoint, nullptr, nullptr, nullptr, nullptr, &advance) != 0) {
+        advance = converted->w;
+    }
+    g.advance = advance;
+
+    // Only the alpha channel matters; skip glyphs with no ink at all
+    int w = converted->w, h = converted->h;
+    std::vector<uint8_t> alpha((size_t)w * h);
+    bool ink = false;
+    const uint8_t* src = (const uint8_t*)converted->pixels;
+    for (int y = 0; y < h; y++) {
+        const uint8_t* row = src + (size_t)y * converted->pitch;
+        for (int x = 0; x < w; x++) {
+            alpha[(size_t)y * w + x] = row[x * 4 + 3];
+            ink |= row[x * 4 + 3] != 0;
+        }
+    }
+    SDL_FreeSurface(converted);
+    if (!ink || !allocate(w, h, g.x, g.y)) return g;
+    g.w = w;
+    g.h = h;
+
+    for (int y = 0; y < h; y++) {
+        memcpy(&pixels[(size_t)(g.y + y) * atlasW + g.x], &alpha[(size_t)y * w], w);
+    }
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, g.x, g.y, w, h, GL_RED, GL_UNSIGNED_BYTE, alpha.data());
+    return g;
+}
+
+bool GlyphAtlas::allocate(int w, int h, int& x, int& y) {
+    if (w + glyphPadding > atlasW) return false;
+    if (shelfX + w + glyphPadding > atlasW) {
+        // Start a new shelf below the tallest glyph of the current one
+        shelfY += shelfH + glyphPadding;
+        shelfX = 0;
+        shelfH = 0;
+    }
+    while (shelfY + h + glyphPadding > atlasH) {
+        if (atlasH >= 8192) {
+            std::cerr << "Glyph atlas is full\n";
+            return false;
+        }
+        grow();
+    }
+    x = shelfX;
+    y = shelfY;
+    shelfX += w + glyphPadding;
+    shelfH = std::max(shelfH, h);
+    return true;
+}
+
+void GlyphAtlas::grow() {
+    // Glyph positions are in pixels, so doubling the height keeps them valid
+    atlasH *= 2;
+    pixels.resize((size_t)atlasW * atlasH, 0);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlasW, atlasH, 0, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+}
+
+float GlyphAtlas::measure(std::string_view text) {
+    float width = 0;
+    for (size_t i = 0; i < text.size();) width += glyph(nextCodepoint(text, i)).advance;
+    return width;
+}
+
+void GlyphAtlas::appendText(std::vector<float>& out, std::string_view text, float x, float y, const glm::vec4& color) {
+    float penX = x;
+    for (size_t i = 0; i < text.size();) {
+        const Glyph& g = glyph(nextCodepoint(text, i));
+        if (g.w > 0) {
+            float x0 = penX, y0 = y, x1 = penX + g.w, y1 = y + g.h;
+            float u0 = g.x, v0 = g.y, u1 = g.x + g.w, v1 = g.y + g.h;
+            float quad[6][4] = {
+                {x0, y0, u0, v0}, {x1, y0, u1, v0}, {x1, y1, u1, v1},
+                {x0, y0, u0, v0}, {x1, y1, u1, v1}, {x0, y1, u0, v1},
+            };
+            for (auto& v : quad) {
+                out.insert(out.end(), {v[0], v[1], v[2], v[3], color.r, color.g, color.b, color.a});
+            }
+        }
+        penX += g.advance;
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <GL/glew.h>
+#include <SDL2/SDL_ttf.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Glyphs rasterized once with SDL_ttf into a single-channel texture, packed
+// shelf by shelf. Text becomes one quad per glyph appended to a vertex
+// array, so any number of strings is drawn with a single call. The atlas
+// grows (doubling its height) when a new glyph no longer fits.
+class GlyphAtlas {
+public:
+    // Floats per vertex written by appendText: x, y, u, v, r, g, b, a. The
+    // texture coordinates are in texels, so quads already queued stay valid
+    // when the atlas grows; the shader divides by the texture size.
+    static const int vertexFloats = 8;
+
+    bool init(TTF_Font* font);
+    void shutdown();
+
+    GLuint texture() const { return tex; }
+    int lineHeight() const { return height; }
+
+    // Width in pixels of text on a single line
+    float measure(std::string_view text);
+    // Appends six vertices per visible glyph, with the top-left of the line at (x, y)
+    void appendText(std::vector<float>& out, std::string_view text, float x, float y, const glm::vec4& color);
+
+private:
+    struct Glyph {
+        int x = 0, y = 0;   // Position in the atlas
+        int w = 0, h = 0;   // 0 for glyphs with no ink, such as spaces
+        float advance = 0;
+    };
+
+    TTF_Font* font = nullptr;
+    GLuint tex = 0;
+    int atlasW = 512, atlasH = 256;
+    std::vector<uint8_t> pixels; // CPU copy, re-uploaded when the atlas grows
+    int shelfX = 0, shelfY = 0, shelfH = 0;
+    int height = 0;
+
+    Glyph ascii[128];
+    bool asciiLoaded[128] = {};
+    std::unordered_map<uint32_t, Glyph> others;
+
+    const Glyph& glyph(uint32_t codepoint);
+    Glyph rasterize(uint32_t codepoint);
+    bool allocate(int w, int h, int& x, int& y);
+    void grow();
+};
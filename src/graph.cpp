@@ -1,91 +1,324 @@
 #include "graph.h"
 #include <algorithm>
+#include <limits>
 #include <cmath>
 #include <iostream>
 
-int Graph::addNode(const std::string& url, const glm::vec3& pos) {
+// Deleted slots are parked far outside the repulsion cutoff so the exact
+// force kernels can stream over them without a per-lane alive check
+static const float deletedPosition = 1e18f;
+
+void NodeArrays::push(const glm::vec3& pos, float nodeSize) {
+    x.push_back(pos.x);
+    y.push_back(pos.y);
+    z.push_back(pos.z);
+    vx.push_back(0.0f);
+    vy.push_back(0.0f);
+    vz.push_back(0.0f);
+    size.push_back(nodeSize);
+    flags.push_back(0);
+}
+
+void NodeArrays::assign(size_t idx, const glm::vec3& pos, float nodeSize, uint8_t nodeFlags) {
+    x[idx] = pos.x;
+    y[idx] = pos.y;
+    z[idx] = pos.z;
+    vx[idx] = vy[idx] = vz[idx] = 0.0f;
+    size[idx] = nodeSize;
+    flags[idx] = nodeFlags;
+}
+
+void NodeArrays::resize(size_t n) {
+    for (auto* v : {&x, &y, &z}) v->resize(n, deletedPosition);
+    for (auto* v : {&vx, &vy, &vz, &size}) v->resize(n, 0.0f);
+    flags.resize(n, NodeDeleted);
+}
+
+void NodeArrays::clear() {
+    x.clear(); y.clear(); z.clear();
+    vx.clear(); vy.clear(); vz.clear();
+    size.clear();
+    flags.clear();
+}
+
+int Graph::addNode(std::string_view url, const glm::vec3& pos) {
+    return addNode(urls.intern(url), pos);
+}
+
+int Graph::addNode(UrlId url, const glm::vec3& pos) {
     Node n;
     n.url = url;
-    n.position = pos;
-    n.pinned = false;  // Explicitly ensure not pinned
-    nodes.push_back(n);
-    return nodes.size() - 1;
+    n.generation = nextGeneration++;
+
+    int idx;
+    if (!freeSlots.empty()) {
+        idx = freeSlots.back();
+        freeSlots.pop_back();
+        nodes[idx] = std::move(n);
+        sim.assign(idx, pos, 0.4f, 0); // Not pinned
+    } else {
+        idx = nodes.size();
+        nodes.push_back(std::move(n));
+        sim.push(pos, 0.4f);
+    }
+
+    if (url >= nodeByUrl.size()) nodeByUrl.resize(urls.size(), -1);
+    if (nodeByUrl[url] < 0) nodeByUrl[url] = idx; // Keeps the first node if the URL is duplicated
+    if (observer) observer->nodeAdded(*this, idx);
+    return idx;
 }
 
 void Graph::addEdge(int from, int to) {
     if (from == to) return;
-    if (from < 0 || from >= (int)nodes.size()) return;
-    if (to < 0 || to >= (int)nodes.size()) return;
-    if (hasEdge(from, to)) return;
+    if (!alive(from) || !alive(to)) return;
+    if (!edgeKeys.insert(edgeKey(from, to)).second) return; // Already connected
     edges.push_back({from, to, 4.5f, 0.0f});
+    int e = edges.size() - 1;
+    nodes[from].edgeIndices.push_back(e);
+    nodes[to].edgeIndices.push_back(e);
     nodes[from].childIndices.push_back(to);
+    if (observer) observer->edgeAdded(*this, from, to);
+}
+
+uint64_t Graph::edgeKey(int a, int b) {
+    // Undirected: order the endpoints so (a, b) and (b, a) collide
+    if (a > b) std::swap(a, b);
+    return ((uint64_t)(uint32_t)a << 32) | (uint32_t)b;
 }
 
 bool Graph::hasEdge(int from, int to) const {
-    for (const auto& e : edges) {
-        if ((e.from == from && e.to == to) || (e.from == to && e.to == from)) {
-            return true;
-        }
-    }
-    return false;
+    return edgeKeys.count(edgeKey(from, to)) > 0;
 }
 
-int Graph::findNodeByUrl(const std::string& url) const {
-    for (size_t i = 0; i < nodes.size(); i++) {
-        if (nodes[i].url == url) return i;
+void Graph::removeEdgeAt(int e) {
+    Edge removed = edges[e];
+    edgeKeys.erase(edgeKey(removed.from, removed.to));
+
+    auto unlink = [](std::vector<int>& list, int value) {
+        auto it = std::find(list.begin(), list.end(), value);
+        if (it != list.end()) {
+            *it = list.back();
+            list.pop_back();
+        }
+    };
+    unlink(nodes[removed.from].edgeIndices, e);
+    unlink(nodes[removed.to].edgeIndices, e);
+    unlink(nodes[removed.from].childIndices, removed.to);
+
+    // Swap-remove: the last edge takes over index e
+    edgeLayoutVersion++;
+    int last = edges.size() - 1;
+    if (e != last) {
+        edges[e] = edges[last];
+        for (int endpoint : {edges[e].from, edges[e].to}) {
+            auto& list = nodes[endpoint].edgeIndices;
+            std::replace(list.begin(), list.end(), last, e);
+        }
     }
-    return -1;
+    edges.pop_back();
 }
 
 void Graph::deleteNode(int idx) {
-    if (idx < 0 || idx >= (int)nodes.size()) return;
-
-    // Remove edges involving this node
-    edges.erase(std::remove_if(edges.begin(), edges.end(), [idx](const Edge& e) {
-        return e.from == idx || e.to == idx;
-    }), edges.end());
+    if (!alive(idx)) return;
+    if (observer) observer->nodeDeleted(*this, idx);
 
-    // Update edge indices for nodes after the deleted one
-    for (auto& e : edges) {
-        if (e.from > idx) e.from--;
-        if (e.to > idx) e.to--;
+    // O(degree): only the edges touching this node are visited
+    while (!nodes[idx].edgeIndices.empty()) {
+        removeEdgeAt(nodes[idx].edgeIndices.back());
     }
 
-    // Update childIndices in all nodes
-    for (auto& n : nodes) {
-        n.childIndices.erase(std::remove_if(n.childIndices.begin(), n.childIndices.end(), [idx](int i) {
-            return i == idx;
-        }), n.childIndices.end());
-        for (auto& ci : n.childIndices) {
-            if (ci > idx) ci--;
-        }
-    }
+    if (nodeByUrl[nodes[idx].url] == idx) nodeByUrl[nodes[idx].url] = -1;
 
-    nodes.erase(nodes.begin() + idx);
+    uint32_t generation = nodes[idx].generation;
+    nodes[idx] = Node();
+    nodes[idx].generation = generation;
+    sim.assign(idx, glm::vec3(deletedPosition), 0.0f, NodeDeleted);
+    freeSlots.push_back(idx);
 }
 
 void Graph::clear() {
     nodes.clear();
+    sim.clear();
     edges.clear();
+    edgeLayoutVersion++;
+    freeSlots.clear();
+    nodeByUrl.clear();
+    edgeKeys.clear();
+    if (observer) observer->cleared(*this);
+}
+
+void Graph::rebuildIndexes() {
+    std::vector<Edge> loaded;
+    loaded.swap(edges);
+    edgeLayoutVersion++;
+    freeSlots.clear();
+    edgeKeys.clear();
+    edgeKeys.reserve(loaded.size());
+    nodeByUrl.assign(urls.size(), -1);
+
+    for (size_t i = 0; i < nodes.size(); i++) {
+        Node& n = nodes[i];
+        n.childIndices.clear();
+        n.edgeIndices.clear();
+        n.generation = nextGeneration++;
+        if (sim.flags[i] & NodeDeleted) {
+            freeSlots.push_back(i);
+        } else if (n.url < nodeByUrl.size() && nodeByUrl[n.url] < 0) {
+            nodeByUrl[n.url] = i;
+        }
+    }
+
+    // Same checks as addEdge, with the adjacency lists sized up front
+    edges.reserve(loaded.size());
+    for (const Edge& e : loaded) {
+        if (e.from == e.to || !alive(e.from) || !alive(e.to)) continue;
+        if (!edgeKeys.insert(edgeKey(e.from, e.to)).second) continue;
+        edges.push_back(e);
+    }
+    std::vector<uint32_t> degree(nodes.size(), 0);
+    for (const Edge& e : edges) {
+        degree[e.from]++;
+        degree[e.to]++;
+    }
+    for (size_t i = 0; i < nodes.size(); i++) nodes[i].edgeIndices.reserve(degree[i]);
+    for (size_t e = 0; e < edges.size(); e++) {
+        nodes[edges[e].from].edgeIndices.push_back(e);
+        nodes[edges[e].to].edgeIndices.push_back(e);
+        nodes[edges[e].from].childIndices.push_back(edges[e].to);
+    }
 }
 
-int Graph::raycast(const glm::vec3& origin, const glm::vec3& dir, float maxDist) const {
+void Graph::setPinned(int idx, bool pin) {
+    if (pin) sim.flags[idx] |= NodePinned;
+    else sim.flags[idx] &= ~NodePinned;
+    if (observer) observer->pinChanged(*this, idx);
+}
+
+// Distance along the ray to where it enters the box, or -1 if it misses
+// the box before maxDist
+static float rayEntersBox(const glm::vec3& origin, const glm::vec3& invDir, const glm::vec3& lo, const glm::vec3& hi,
+                          float maxDist) {
+    float tNear = 0.0f, tFar = maxDist;
+    for (int axis = 0; axis < 3; axis++) {
+        float t1 = (lo[axis] - origin[axis]) * invDir[axis];
+        float t2 = (hi[axis] - origin[axis]) * invDir[axis];
+        tNear = std::max(tNear, std::min(t1, t2));
+        tFar = std::min(tFar, std::max(t1, t2));
+    }
+    return tNear <= tFar ? tNear : -1.0f;
+}
+
+int Graph::raycast(const glm::vec3& origin, const glm::vec3& dir, float maxDist, const Octree* index) const {
     int closest = -1;
     float closestDist = maxDist;
 
-    for (size_t i = 0; i < nodes.size(); i++) {
-        glm::vec3 toNode = nodes[i].position - origin;
+    auto test = [&](int i) {
+        if (sim.flags[i] & NodeDeleted) return;
+        glm::vec3 pos = position(i);
+        glm::vec3 toNode = pos - origin;
         float t = glm::dot(toNode, dir);
-        if (t < 0) continue;
+        if (t < 0) return;
 
         glm::vec3 closestPoint = origin + dir * t;
-        float dist = glm::length(nodes[i].position - closestPoint);
-        float radius = nodes[i].size * 0.5f;
+        float dist = glm::length(pos - closestPoint);
+        float radius = sim.size[i] * 0.5f;
 
         if (dist < radius && t < closestDist) {
             closestDist = t;
             closest = i;
         }
+    };
+
+    int covered = 0;
+    if (index && !index->empty()) {
+        const auto& cells = index->cells();
+        const auto& order = index->indices();
+        covered = std::min<int>(index->pointCount(), nodes.size());
+
+        glm::vec3 invDir;
+        for (int axis = 0; axis < 3; axis++) {
+            invDir[axis] = dir[axis] != 0.0f ? 1.0f / dir[axis] : std::numeric_limits<float>::max();
+        }
+        // A hit lies inside its cell's bounds padded by the largest pick radius,
+        // so cells entered beyond the closest hit so far can be skipped
+        auto entry = [&](int c) {
+            const Octree::Cell& cell = cells[c];
+            if (cell.count == 0) return -1.0f;
+            float pad = cell.maxSize * 0.5f;
+            return rayEntersBox(origin, invDir, cell.lo - pad, cell.hi + pad, closestDist);
+        };
+
+        std::vector<std::pair<float, int>> stack; // Entry distance, cell
+        float rootEntry = entry(0);
+        if (rootEntry >= 0) stack.push_back({rootEntry, 0});
+        while (!stack.empty()) {
+            auto [t, c] = stack.back();
+            stack.pop_back();
+            if (t >= closestDist) continue;
+
+            const Octree::Cell& cell = cells[c];
+            if (cell.firstChild < 0) {
+                for (int k = cell.begin; k < cell.end; k++) {
+                    if (order[k] < covered) test(order[k]);
+                }
+                continue;
+            }
+            // Nearest child on top of the stack
+            size_t base = stack.size();
+            for (int k = cell.firstChild; k < cell.firstChild + cell.childCount; k++) {
+                float childEntry = entry(k);
+                if (childEntry >= 0) stack.push_back({childEntry, k});
+            }
+            std::sort(stack.begin() + base, stack.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+        }
     }
+    if (covered > 0) {
+        for (int i : index->excluded()) {
+            if (i < covered) test(i);
+        }
+    }
+    for (int i = covered; i < (int)nodes.size(); i++) test(i);
     return closest;
 }
+
+void Graph::select(const Frustum& volume, std::vector<int>& out, const Octree* index) const {
+    auto test = [&](int i, bool inside) {
+        if (sim.flags[i] & NodeDeleted) return;
+        if (inside || volume.sphere(position(i), sim.size[i] * 0.5f)) out.push_back(i);
+    };
+
+    int covered = 0;
+    if (index && !index->empty()) {
+        const auto& cells = index->cells();
+        const auto& order = index->indices();
+        covered = std::min<int>(index->pointCount(), nodes.size());
+
+        std::vector<std::pair<int, bool>> stack; // Cell, known to be inside
+        stack.push_back({0, false});
+        while (!stack.empty()) {
+            auto [c, inside] = stack.back();
+            stack.pop_back();
+            const Octree::Cell& cell = cells[c];
+            if (cell.count == 0) continue;
+            if (!inside) {
+                // Fully inside on the unpadded bounds means every center is inside
+                float pad = cell.maxSize * 0.5f;
+                if (volume.classify(cell.lo - pad, cell.hi + pad) < 0) continue;
+                inside = volume.classify(cell.lo, cell.hi) > 0;
+            }
+            if (cell.firstChild < 0 || inside) {
+                for (int k = cell.begin; k < cell.end; k++) {
+                    if (order[k] < covered) test(order[k], inside);
+                }
+                continue;
+            }
+            for (int k = cell.firstChild; k < cell.firstChild + cell.childCount; k++) stack.push_back({k, false});
+        }
+    }
+    if (covered > 0) {
+        for (int i : index->excluded()) {
+            if (i < covered) test(i, false);
+        }
+    }
+    for (int i = covered; i < (int)nodes.size(); i++) test(i, false);
+}
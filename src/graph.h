@@ -1,25 +1,61 @@
 #pragma once
+#include "url.h"
+#include "frustum.h"
+#include "octree.h"
 #include <glm/glm.hpp>
-#include <string>
+#include <cstdint>
+#include <string_view>
+#include <unordered_set>
 #include <vector>
 
 enum class NodeStatus { Pending, Success, Error };
 
+// Stable reference to a node. Slots are reused after deletion; the
+// generation tells the new occupant apart from the node that was deleted.
+struct NodeHandle {
+    int slot = -1;
+    uint32_t generation = 0;
+
+    bool operator==(const NodeHandle& o) const { return slot == o.slot && generation == o.generation; }
+    bool operator!=(const NodeHandle& o) const { return !(*this == o); }
+};
+
+// Cold per-node data. Simulation state lives in Graph::sim.
 struct Node {
-    glm::vec3 position{0.0f};
-    glm::vec3 velocity{0.0f};
-    std::string url;
+    UrlId url = UrlTable::none;     // Spelled out by Graph::url()
     int httpCode = 0; // 0 = pending, 200 = ok, 404 = not found, etc.
-    std::vector<std::string> links;
+    std::vector<UrlId> links;
     std::vector<int> childIndices;
+    std::vector<int> edgeIndices; // Every edge touching this node
     int parentIndex = -1;
-    float size = 0.4f;
+    uint32_t generation = 0;
     float targetSize = 0.4f;
     float fadeIn = 0.0f; // 0 = invisible, 1 = fully visible
     NodeStatus status = NodeStatus::Pending;
     bool expanded = false;
     bool fetching = false;
-    bool pinned = false;
+};
+
+enum NodeFlags : uint8_t {
+    NodePinned = 1 << 0,
+    NodeDeleted = 1 << 1, // Free slot, waiting to be reused
+    NodeAsleep = 1 << 2,  // Settled; Physics skips it until something wakes it
+};
+
+// Hot simulation state as structure-of-arrays, indexed like Graph::nodes,
+// so the physics passes stream contiguous floats
+struct NodeArrays {
+    std::vector<float> x, y, z;
+    std::vector<float> vx, vy, vz;
+    std::vector<float> size;
+    std::vector<uint8_t> flags;
+
+    size_t count() const { return x.size(); }
+    void push(const glm::vec3& pos, float nodeSize);
+    void assign(size_t idx, const glm::vec3& pos, float nodeSize, uint8_t nodeFlags);
+    // Slots added by growing are deleted ones, parked like Graph::deleteNode does
+    void resize(size_t n);
+    void clear();
 };
 
 struct Edge {
@@ -28,16 +64,104 @@ struct Edge {
     float fadeIn = 0.0f; // 0 = invisible, 1 = fully visible
 };
 
+class Graph;
+
+// Told about every structural change to a Graph, after it happened (before,
+// for nodeDeleted). Direct writes to the public arrays are not reported.
+class GraphObserver {
+public:
+    virtual ~GraphObserver() = default;
+    virtual void nodeAdded(const Graph& graph, int idx) {}
+    virtual void edgeAdded(const Graph& graph, int from, int to) {}
+    virtual void nodeFetched(const Graph& graph, int idx) {}
+    virtual void nodeDeleted(const Graph& graph, int idx) {}
+    virtual void pinChanged(const Graph& graph, int idx) {}
+    virtual void nodeExpanded(const Graph& graph, int idx) {}
+    virtual void cleared(const Graph& graph) {}
+};
+
+// Forwards every notification to each observer in the list, in order
+class GraphObserverList : public GraphObserver {
+public:
+    std::vector<GraphObserver*> list;
+
+    void nodeAdded(const Graph& graph, int idx) override { for (auto* o : list) o->nodeAdded(graph, idx); }
+    void edgeAdded(const Graph& graph, int from, int to) override { for (auto* o : list) o->edgeAdded(graph, from, to); }
+    void nodeFetched(const Graph& graph, int idx) override { for (auto* o : list) o->nodeFetched(graph, idx); }
+    void nodeDeleted(const Graph& graph, int idx) override { for (auto* o : list) o->nodeDeleted(graph, idx); }
+    void pinChanged(const Graph& graph, int idx) override { for (auto* o : list) o->pinChanged(graph, idx); }
+    void nodeExpanded(const Graph& graph, int idx) override { for (auto* o : list) o->nodeExpanded(graph, idx); }
+    void cleared(const Graph& graph) override { for (auto* o : list) o->cleared(graph); }
+};
+
+// Node indices are slots: they stay valid until the node is deleted, after
+// which the slot is marked NodeDeleted and recycled by the next addNode.
+// Loops over nodes must skip slots where alive() is false.
 class Graph {
 public:
     std::vector<Node> nodes;
+    NodeArrays sim;
     std::vector<Edge> edges;
+    // Every URL a node or link list refers to. Kept across clear() since
+    // in-flight fetches may still hold views into it.
+    UrlTable urls;
+    GraphObserver* observer = nullptr;
 
-    int addNode(const std::string& url, const glm::vec3& pos);
+    int addNode(std::string_view url, const glm::vec3& pos);
+    int addNode(UrlId url, const glm::vec3& pos);
     void addEdge(int from, int to);
     bool hasEdge(int from, int to) const;
-    int findNodeByUrl(const std::string& url) const;
+    int findNodeByUrl(std::string_view url) const { return findNodeByUrl(urls.find(url)); }
+    int findNodeByUrl(UrlId url) const { return url < nodeByUrl.size() ? nodeByUrl[url] : -1; }
     void deleteNode(int idx);
     void clear();
-    int raycast(const glm::vec3& origin, const glm::vec3& dir, float maxDist = 100.0f) const;
+    // Rebuilds the lookup indexes, adjacency lists and generations after
+    // nodes, sim and edges were filled in directly (e.g. by a loader).
+    // Duplicate and dangling edges are dropped.
+    void rebuildIndexes();
+    // Nearest node whose pick sphere (radius size / 2) the ray hits within
+    // maxDist. Given a spatial index over this graph's slots (such as
+    // Physics::spatialIndex), only the cells along the ray are searched;
+    // slots added or reused since it was built are tested one by one.
+    int raycast(const glm::vec3& origin, const glm::vec3& dir, float maxDist = 100.0f,
+                const Octree* index = nullptr) const;
+    // Appends every node whose pick sphere touches volume
+    void select(const Frustum& volume, std::vector<int>& out, const Octree* index = nullptr) const;
+
+    std::string_view url(int idx) const { return urls.str(nodes[idx].url); }
+    bool alive(int idx) const { return idx >= 0 && idx < (int)nodes.size() && !(sim.flags[idx] & NodeDeleted); }
+    int nodeCount() const { return (int)(nodes.size() - freeSlots.size()); }
+    NodeHandle handle(int idx) const { return {idx, nodes[idx].generation}; }
+    int resolve(const NodeHandle& h) const { return alive(h.slot) && nodes[h.slot].generation == h.generation ? h.slot : -1; }
+
+    glm::vec3 position(int idx) const { return glm::vec3(sim.x[idx], sim.y[idx], sim.z[idx]); }
+    void setPosition(int idx, const glm::vec3& p) { sim.x[idx] = p.x; sim.y[idx] = p.y; sim.z[idx] = p.z; }
+    glm::vec3 velocity(int idx) const { return glm::vec3(sim.vx[idx], sim.vy[idx], sim.vz[idx]); }
+    void setVelocity(int idx, const glm::vec3& v) { sim.vx[idx] = v.x; sim.vy[idx] = v.y; sim.vz[idx] = v.z; }
+    float size(int idx) const { return sim.size[idx]; }
+    void setSize(int idx, float s) { sim.size[idx] = s; }
+    bool pinned(int idx) const { return sim.flags[idx] & NodePinned; }
+    void setPinned(int idx, bool pin);
+    // Call once a fetch result (status, httpCode, links) was stored in the node
+    void fetched(int idx) { if (observer) observer->nodeFetched(*this, idx); }
+    // Marks a node whose links were queued for spawning
+    void setExpanded(int idx) {
+        nodes[idx].expanded = true;
+        if (observer) observer->nodeExpanded(*this, idx);
+    }
+    // Changes whenever edges are removed or reordered, but not when one is
+    // appended, so mirrors of the edge array can tell the two apart
+    uint32_t edgeLayout() const { return edgeLayoutVersion; }
+
+private:
+    std::vector<int> freeSlots;
+    uint32_t nextGeneration = 1; // Never reset, so handles stay unique across clear()
+    uint32_t edgeLayoutVersion = 0;
+
+    // Lookup indexes kept in sync by the mutation methods above
+    std::vector<int> nodeByUrl; // Indexed by UrlId, -1 where there is no node
+    std::unordered_set<uint64_t> edgeKeys;
+
+    static uint64_t edgeKey(int a, int b);
+    void removeEdgeAt(int e);
 };
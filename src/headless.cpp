@@ -0,0 +1,143 @@
+#include "headless.h"
+#include "crawler.h"
+#include "graph.h"
+#include "physics.h"
+#include "snapshot.h"
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Set by SIGINT/SIGTERM: stop crawling and save what we have
+static volatile std::sig_atomic_t stopRequested = 0;
+
+static void requestStop(int) {
+    stopRequested = 1;
+}
+
+static void printUsage() {
+    std::cerr << "Usage: constellarix --headless [options] URL...\n"
+              << "  --depth N        Follow links up to N hops from a seed (default 2)\n"
+              << "  --max-nodes N    Stop adding nodes at N (default 10000, 0 = no limit)\n"
+              << "  --layout STEPS   Run up to STEPS physics steps after the crawl, fewer if the\n"
+              << "                   layout settles first (default 0)\n"
+              << "  --rate R         Requests per second per host (default 8)\n"
+              << "  --out FILE       Snapshot to write (default " << defaultSnapshotPath() << ")\n"
+              << "  --no-cache       Ignore and don't fill the response cache\n";
+}
+
+int runHeadless(int argc, char* argv[]) {
+    int maxDepth = 2;
+    size_t maxNodes = 10000;
+    int layoutSteps = 0;
+    float rate = 8.0f;
+    bool useCache = true;
+    std::string outPath = defaultSnapshotPath();
+    std::vector<std::string> seeds;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--headless") {
+            continue;
+        } else if (arg == "--depth" && hasValue) {
+            maxDepth = std::stoi(argv[++i]);
+        } else if (arg == "--max-nodes" && hasValue) {
+            maxNodes = std::stoul(argv[++i]);
+        } else if (arg == "--layout" && hasValue) {
+            layoutSteps = std::stoi(argv[++i]);
+        } else if (arg == "--rate" && hasValue) {
+            rate = std::stof(argv[++i]);
+        } else if (arg == "--out" && hasValue) {
+            outPath = argv[++i];
+        } else if (arg == "--no-cache") {
+            useCache = false;
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            std::cerr << "Unknown option " << arg << "\n";
+            printUsage();
+            return 1;
+        } else {
+            seeds.push_back(arg);
+        }
+    }
+    if (seeds.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    Graph graph;
+    // Written from the network thread, so it has to outlive the HttpClient
+    ResponseCache responseCache;
+    if (useCache) responseCache.open();
+    HttpClient http;
+    FetchScheduler fetcher(http);
+    fetcher.requestsPerSecond = rate;
+    fetcher.verbose = false;
+    Crawler crawler(graph, fetcher, useCache ? &responseCache : nullptr);
+    crawler.verbose = false;
+    crawler.autoExpand = true;
+    crawler.maxDepth = maxDepth;
+    crawler.maxNodes = maxNodes;
+
+    for (const auto& seed : seeds) {
+        crawler.addSeed(seed, glm::vec3(0.0f), FetchPriority::Interactive);
+    }
+
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+    auto lastReport = start;
+    while (!stopRequested && !crawler.idle()) {
+        fetcher.update();
+        // No frames to pace: spawn everything queued, in slices so the
+        // results coming back keep being picked up
+        auto slice = Clock::now() + std::chrono::milliseconds(20);
+        while (crawler.hasPendingLinks() && Clock::now() < slice) {
+            crawler.spawnPending(slice);
+        }
+        // Otherwise nothing to do until the network thread delivers more
+        if (!crawler.hasPendingLinks()) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+        auto now = Clock::now();
+        if (now - lastReport >= std::chrono::seconds(1)) {
+            lastReport = now;
+            std::cout << graph.nodeCount() << " nodes, " << graph.edges.size() << " edges, "
+                      << fetcher.inFlightCount() << " in flight, " << fetcher.queuedCount() << " queued, "
+                      << crawler.pendingCount() << " links to spawn\n";
+        }
+    }
+    float seconds = std::chrono::duration<float>(Clock::now() - start).count();
+    std::cout << (stopRequested ? "Interrupted" : "Crawl finished") << " after " << seconds << " s: "
+              << graph.nodeCount() << " nodes, " << graph.edges.size() << " edges\n";
+
+    // No render loop to ease sizes in, so settle them before the layout
+    for (size_t i = 0; i < graph.nodes.size(); i++) {
+        if (graph.alive(i)) graph.setSize(i, graph.nodes[i].targetSize);
+    }
+    if (layoutSteps > 0 && !stopRequested) {
+        Physics physics;
+        auto layoutStart = Clock::now();
+        int steps = 0;
+        while (steps < layoutSteps && !stopRequested && !physics.settled()) {
+            physics.update(graph, 1.0f / 60.0f);
+            steps++;
+        }
+        std::cout << "Layout: " << steps << (physics.settled() ? " steps, settled, in " : " steps in ")
+                  << std::chrono::duration<float>(Clock::now() - layoutStart).count() << " s\n";
+    }
+
+    if (!saveSnapshot(graph, outPath)) return 1;
+    std::cout << "Wrote " << outPath << "\n";
+    return 0;
+}
+
+#ifdef CONSTELLARIX_HEADLESS_ONLY
+// Server build without SDL or GL (make constellarix-headless)
+int main(int argc, char* argv[]) {
+    return runHeadless(argc, argv);
+}
+#endif
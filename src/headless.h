@@ -0,0 +1,7 @@
+#pragma once
+
+// Crawls without a window or GL context and writes the result as a
+// snapshot for the viewer to --load. Handles the command line itself:
+//   --headless [--depth N] [--max-nodes N] [--layout STEPS] [--rate R]
+//              [--out FILE] [--no-cache] URL...
+int runHeadless(int argc, char* argv[]);
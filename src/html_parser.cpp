@@ -1,63 +1,271 @@
 #include "html_parser.h"
-#include <regex>
-#include <set>
+#include <algorithm>
+#include <cstring>
 
-std::string normalizeUrl(const std::string& url, const std::string& baseUrl) {
-    if (url.empty() || url[0] == '#') return "";
-    if (url.find("javascript:") == 0 || url.find("mailto:") == 0) return "";
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HREF_SCANNER_X86 1
+#endif
 
-    // Already absolute
-    if (url.find("http://") == 0 || url.find("https://") == 0) {
-        return url;
+// Longer values are almost certainly not links (inline data, broken markup)
+static const size_t maxLinkLength = 4096;
+
+LinkExtractor::LinkExtractor(const std::string& baseUrl, size_t maxLinks, const UrlOptions& options)
+    : resolver(options), maxLinks(maxLinks) {
+    resolver.setBase(baseUrl);
+    pageUrl = resolver.base();
+}
+
+static bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+static bool isTagNameChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-';
+}
+
+// Follows '<' and '>' through bytes the scanner passes over, so the tag an
+// href sits in is known however the body was split into chunks. Quoted
+// attribute values are not tracked; a '>' inside one ends the tag early.
+void LinkExtractor::trackTags(const char* data, size_t len) {
+    // Only the last tag boundary matters: search back for it
+    size_t from = 0;
+    for (size_t k = len; k > 0; k--) {
+        char c = data[k - 1];
+        if (c == '>') {
+            tagState = TagState::Outside;
+            return;
+        }
+        if (c == '<') {
+            tagState = TagState::Name;
+            tagNameLength = 0;
+            from = k;
+            break;
+        }
     }
+    if (tagState != TagState::Name) return;
+    for (size_t k = from; k < len; k++) {
+        if (!isTagNameChar(data[k]) && !(tagNameLength == 0 && data[k] == '/')) {
+            tagState = TagState::Inside;
+            return;
+        }
+        if (tagNameLength < 4) tagName[tagNameLength] = data[k] | 0x20;
+        tagNameLength++;
+    }
+}
 
-    // Extract base from baseUrl
-    std::string base = baseUrl;
-    size_t protoEnd = base.find("://");
-    if (protoEnd == std::string::npos) return "";
+bool LinkExtractor::inBaseTag() const {
+    return tagState == TagState::Inside && tagNameLength == 4 && memcmp(tagName, "base", 4) == 0;
+}
+
+// OR-ing 0x20 folds ASCII upper case onto lower case, and no other byte
+// lands on 'h', 'r', 'e' or 'f'
+static inline bool isHref(const char* p) {
+    return (p[0] | 0x20) == 'h' && (p[1] | 0x20) == 'r' && (p[2] | 0x20) == 'e' && (p[3] | 0x20) == 'f';
+}
+
+// The finders return the offset of the first "href" in p[0, n), or an
+// offset at most 3 from the end when there is none, so a match cut off
+// by the end of the chunk is still seen by the state machine.
+static size_t findHrefTail(const char* p, size_t n, size_t k) {
+    for (; k + 4 <= n; k++) {
+        if (isHref(p + k)) return k;
+    }
+    return k;
+}
 
-    size_t pathStart = base.find('/', protoEnd + 3);
-    std::string domain = (pathStart != std::string::npos) ? base.substr(0, pathStart) : base;
+static size_t findHrefScalar(const char* p, size_t n) {
+    return findHrefTail(p, n, 0);
+}
 
-    if (url[0] == '/') {
-        // Absolute path
-        return domain + url;
-    } else {
-        // Relative path
-        if (pathStart != std::string::npos) {
-            size_t lastSlash = base.rfind('/');
-            return base.substr(0, lastSlash + 1) + url;
+#ifdef HREF_SCANNER_X86
+// Compare the first and last byte of every 4-byte window at once and only
+// verify the few positions where both match
+static size_t findHrefSSE(const char* p, size_t n) {
+    const __m128i fold = _mm_set1_epi8(0x20);
+    const __m128i h = _mm_set1_epi8('h');
+    const __m128i f = _mm_set1_epi8('f');
+    size_t k = 0;
+    for (; k + 16 + 3 <= n; k += 16) {
+        __m128i first = _mm_or_si128(_mm_loadu_si128((const __m128i*)(p + k)), fold);
+        __m128i last = _mm_or_si128(_mm_loadu_si128((const __m128i*)(p + k + 3)), fold);
+        unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, h), _mm_cmpeq_epi8(last, f)));
+        while (mask) {
+            size_t at = k + __builtin_ctz(mask);
+            if (isHref(p + at)) return at;
+            mask &= mask - 1;
         }
-        return domain + "/" + url;
     }
+    return findHrefTail(p, n, k);
 }
 
-std::vector<std::string> extractLinks(const std::string& html, const std::string& baseUrl) {
-    std::vector<std::string> links;
-    std::set<std::string> seen;
+__attribute__((target("avx2")))
+static size_t findHrefAVX2(const char* p, size_t n) {
+    const __m256i fold = _mm256_set1_epi8(0x20);
+    const __m256i h = _mm256_set1_epi8('h');
+    const __m256i f = _mm256_set1_epi8('f');
+    size_t k = 0;
+    for (; k + 32 + 3 <= n; k += 32) {
+        __m256i first = _mm256_or_si256(_mm256_loadu_si256((const __m256i*)(p + k)), fold);
+        __m256i last = _mm256_or_si256(_mm256_loadu_si256((const __m256i*)(p + k + 3)), fold);
+        unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(first, h), _mm256_cmpeq_epi8(last, f)));
+        while (mask) {
+            size_t at = k + __builtin_ctz(mask);
+            if (isHref(p + at)) return at;
+            mask &= mask - 1;
+        }
+    }
+    return findHrefTail(p, n, k);
+}
+#endif
 
-    // Limit input size to prevent regex stack overflow
-    std::string safeHtml = html.length() > 500000 ? html.substr(0, 500000) : html;
+struct HrefScanner {
+    size_t (*find)(const char*, size_t) = findHrefScalar;
+    const char* name = "scalar";
 
-    try {
-        // Simple regex for href="..." or href='...'
-        std::regex hrefRegex(R"(href\s*=\s*["']([^"']+)["'])", std::regex::icase);
+    HrefScanner() {
+#ifdef HREF_SCANNER_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            find = findHrefAVX2;
+            name = "avx2";
+        } else if (__builtin_cpu_supports("sse2")) {
+            find = findHrefSSE;
+            name = "sse2";
+        }
+#endif
+    }
+};
+
+static const HrefScanner& hrefScanner() {
+    static HrefScanner scanner;
+    return scanner;
+}
 
-        auto begin = std::sregex_iterator(safeHtml.begin(), safeHtml.end(), hrefRegex);
-        auto end = std::sregex_iterator();
+const char* hrefScannerName() {
+    return hrefScanner().name;
+}
 
-        for (auto it = begin; it != end; ++it) {
-            std::string url = (*it)[1].str();
-            std::string normalized = normalizeUrl(url, baseUrl);
+void LinkExtractor::feed(const char* data, size_t len) {
+    static const char name[] = "href";
+    auto find = hrefScanner().find;
+    if (full()) return;
 
-            if (!normalized.empty() && seen.find(normalized) == seen.end()) {
-                seen.insert(normalized);
-                links.push_back(normalized);
+    for (size_t i = 0; i < len; i++) {
+        char c = data[i];
+        switch (state) {
+        case State::Scan: {
+            // Not inside a partial match: jump straight to the next candidate
+            if (matched == 0) {
+                size_t skip = find(data + i, len - i);
+                trackTags(data + i, std::min(skip, len - i));
+                i += skip;
+                if (i >= len) return;
+                c = data[i];
+            }
+            trackTags(&c, 1);
+            char lower = c | 0x20;
+            if (lower == name[matched]) {
+                if (++matched == 4) {
+                    matched = 0;
+                    state = State::AfterName;
+                    valueIsBase = !baseFromDocument && inBaseTag();
+                }
+            } else {
+                // "href" has no repeated prefix, so a mismatch can only restart on 'h'
+                matched = lower == 'h' ? 1 : 0;
+            }
+            break;
+        }
+        case State::AfterName:
+            if (c == '=') state = State::AfterEquals;
+            else if (!isSpace(c)) { state = State::Scan; i--; }
+            break;
+        case State::AfterEquals:
+            if (c == '"' || c == '\'') {
+                quote = c;
+                value.clear();
+                state = State::InValue;
+            } else if (c == '>') {
+                tagState = TagState::Outside;
+                state = State::Scan;
+            } else if (!isSpace(c)) {
+                value.assign(1, c);
+                state = State::InUnquotedValue;
+            }
+            break;
+        case State::InValue: {
+            // Copy up to the closing quote in one go
+            const char* end = (const char*)memchr(data + i, quote, len - i);
+            size_t stop = end ? end - data : len;
+            if (!overlong) {
+                value.append(data + i, stop - i);
+                if (value.size() > maxLinkLength) {
+                    value.clear();
+                    overlong = true;
+                }
+            }
+            i = stop;
+            if (end) {
+                if (!overlong) emit();
+                value.clear();
+                overlong = false;
+                state = State::Scan;
+                if (full()) return;
+            }
+            break;
+        }
+        case State::InUnquotedValue:
+            if (isSpace(c) || c == '>') {
+                if (c == '>') tagState = TagState::Outside;
+                emit();
+                state = State::Scan;
+                if (full()) return;
+            } else if (value.size() < maxLinkLength) {
+                value.push_back(c);
+            } else {
+                value.clear();
+                state = State::Scan;
             }
+            break;
         }
-    } catch (...) {
-        // Regex failed, return empty
+    }
+}
+
+void LinkExtractor::emit() {
+    if (valueIsBase) {
+        // Later links resolve against the document's base. Copy first: the
+        // resolved view points into the resolver's own buffer.
+        std::string newBase(resolver.resolve(value));
+        if (!newBase.empty()) resolver.setBase(newBase);
+        baseFromDocument = true;
+        return;
     }
 
+    std::string_view url = resolver.resolve(value);
+    // Fragment-only and empty references come back as the page itself
+    if (url.empty() || url == pageUrl) return;
+    if (seen.find(url) != seen.end()) return;
+    url = arena.store(url);
+    seen.insert(url);
+    found.emplace_back(url);
+}
+
+void LinkExtractor::finish() {
+    if (state == State::InUnquotedValue && !full()) emit();
+    value.clear();
+    state = State::Scan;
+}
+
+std::vector<std::string> LinkExtractor::takeLinks() {
+    std::vector<std::string> links;
+    links.swap(found);
     return links;
 }
+
+std::vector<std::string> extractLinks(const std::string& html, const std::string& baseUrl) {
+    LinkExtractor extractor(baseUrl);
+    extractor.feed(html.data(), html.size());
+    extractor.finish();
+    return extractor.takeLinks();
+}
@@ -1,6 +1,56 @@
 #pragma once
+#include "url.h"
+#include <cstddef>
 #include <string>
+#include <string_view>
+#include <unordered_set>
 #include <vector>
 
+// Incremental href attribute scanner. Body chunks can be fed as they arrive;
+// matches split across chunk boundaries are carried over, and only the
+// value of the attribute being read is buffered. Values may be single-,
+// double- or un-quoted. Links are canonicalized with UrlResolver, against
+// the page URL or the document's <base href> once one is seen.
+class LinkExtractor {
+public:
+    // A non-zero maxLinks stops scanning once that many unique links were found
+    explicit LinkExtractor(const std::string& baseUrl, size_t maxLinks = 0, const UrlOptions& options = {});
+
+    void feed(const char* data, size_t len);
+    // End of the document: emits an unquoted value cut off by it
+    void finish();
+    // Links found since the last call, normalized and deduplicated
+    std::vector<std::string> takeLinks();
+
+    size_t linkCount() const { return seen.size(); }
+    bool full() const { return maxLinks && seen.size() >= maxLinks; }
+
+private:
+    enum class State { Scan, AfterName, AfterEquals, InValue, InUnquotedValue };
+    // Where the scanner is relative to markup, to know which tag an href belongs to
+    enum class TagState { Outside, Name, Inside };
+
+    UrlResolver resolver;
+    std::string pageUrl;    // Canonical page URL; <base> does not change it
+    UrlArena arena;         // Backs the views in seen
+    size_t maxLinks;
+    bool baseFromDocument = false; // Only the first <base href> counts
+    bool valueIsBase = false;      // Current value belongs to a <base> tag
+    TagState tagState = TagState::Outside;
+    char tagName[5] = {};          // Lower-cased start of the open tag's name
+    int tagNameLength = 0;         // Characters of it seen, past 4 only counted
+    State state = State::Scan;
+    int matched = 0;        // Characters of "href" matched so far
+    std::string value;      // Attribute value being collected
+    char quote = 0;         // Quote that opened the value
+    bool overlong = false;  // Value exceeded the length cap and is being skipped
+    std::vector<std::string> found;
+    std::unordered_set<std::string_view> seen;
+
+    void emit();
+    void trackTags(const char* data, size_t len);
+    bool inBaseTag() const;
+};
+
 std::vector<std::string> extractLinks(const std::string& html, const std::string& baseUrl);
-std::string normalizeUrl(const std::string& url, const std::string& baseUrl);
+const char* hrefScannerName();
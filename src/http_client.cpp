@@ -1,69 +1,251 @@
 #include "http_client.h"
 #include <curl/curl.h>
 #include <algorithm>
+#include <cctype>
 #include <iostream>
 
-static size_t writeCallback(void* contents, size_t size, size_t nmemb, std::string* out) {
+size_t HttpClient::writeBody(char* data, size_t size, size_t nmemb, void* userdata) {
+    auto* transfer = (Transfer*)userdata;
     size_t totalSize = size * nmemb;
-    out->append((char*)contents, totalSize);
+
+    // Only successful bodies are streamed; error pages are small and kept whole
+    if (transfer->options.onBody) {
+        long code = 0;
+        curl_easy_getinfo((CURL*)transfer->easy, CURLINFO_RESPONSE_CODE, &code);
+        if (code >= 200 && code < 300) {
+            transfer->options.onBody(data, totalSize);
+            return totalSize;
+        }
+    }
+    transfer->result.response.body.append(data, totalSize);
+    return totalSize;
+}
+
+static size_t headerCallback(char* buffer, size_t size, size_t nitems, HttpResponse* out) {
+    size_t totalSize = size * nitems;
+    std::string line(buffer, totalSize);
+    while (!line.empty() && (line.back() == '\r' || line.back() == '\n')) line.pop_back();
+
+    // A new status line starts another response (redirects), keep only the last one's headers
+    if (line.compare(0, 5, "HTTP/") == 0) {
+        out->headers.clear();
+        return totalSize;
+    }
+    size_t colon = line.find(':');
+    if (colon == std::string::npos) return totalSize;
+
+    std::string name = line.substr(0, colon);
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    size_t valueStart = line.find_first_not_of(" \t", colon + 1);
+    out->headers[name] = valueStart == std::string::npos ? "" : line.substr(valueStart);
     return totalSize;
 }
 
-HttpClient::HttpClient() {
+HttpClient::HttpClient(int maxConcurrent, int maxPerHost)
+    : maxConcurrent(std::max(1, maxConcurrent)), maxPerHost(std::max(1, maxPerHost)) {
     curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    // Only the loop thread touches the share, so no lock callbacks are needed
+    CURLSH* sh = curl_share_init();
+    curl_share_setopt(sh, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(sh, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    curl_share_setopt(sh, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    share = sh;
+
+    CURLM* m = curl_multi_init();
+    curl_multi_setopt(m, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    curl_multi_setopt(m, CURLMOPT_MAX_HOST_CONNECTIONS, (long)this->maxPerHost);
+    multi = m;
+
+    loopThread = std::thread(&HttpClient::eventLoop, this);
 }
 
 HttpClient::~HttpClient() {
-    for (auto& req : pending) {
-        if (req->thread.joinable()) req->thread.join();
-    }
+    stopping = true;
+    curl_multi_wakeup((CURLM*)multi);
+    loopThread.join();
+
+    curl_multi_cleanup((CURLM*)multi);
+    curl_share_cleanup((CURLSH*)share);
     curl_global_cleanup();
 }
 
-void HttpClient::fetchAsync(const std::string& url, std::function<void(HttpResponse)> callback) {
-    auto req = std::make_unique<PendingRequest>();
-    req->callback = std::move(callback);
-
-    auto* reqPtr = req.get();
-    req->thread = std::thread([reqPtr, url]() {
-        CURL* curl = curl_easy_init();
-        if (!curl) {
-            reqPtr->response.error = "Failed to init curl";
-            reqPtr->done = true;
-            return;
-        }
+void HttpClient::fetchAsync(const std::string& url, std::function<void(HttpResponse)> callback, FetchOptions options) {
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        jobs.push({nextSequence++, url, std::move(callback), std::move(options)});
+    }
+    curl_multi_wakeup((CURLM*)multi);
+}
 
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &reqPtr->response.body);
-        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
-        curl_easy_setopt(curl, CURLOPT_USERAGENT, "WebGraph3D/1.0");
-
-        CURLcode res = curl_easy_perform(curl);
-        if (res != CURLE_OK) {
-            reqPtr->response.error = curl_easy_strerror(res);
-        } else {
-            long code;
-            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
-            reqPtr->response.statusCode = (int)code;
-        }
+void HttpClient::runAsync(std::function<void()> work, std::function<void()> callback) {
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        tasks.push_back({std::move(work), std::move(callback)});
+    }
+    curl_multi_wakeup((CURLM*)multi);
+}
 
-        curl_easy_cleanup(curl);
-        reqPtr->done = true;
-    });
+void HttpClient::update(std::chrono::steady_clock::time_point deadline) {
+    {
+        std::lock_guard<std::mutex> lock(completedMutex);
+        for (auto& c : completed) ready.push_back(std::move(c));
+        completed.clear();
+    }
+    while (!ready.empty()) {
+        Completion c = std::move(ready.front());
+        ready.pop_front();
+        c.callback(std::move(c.response));
+        if (std::chrono::steady_clock::now() >= deadline) break;
+    }
+}
+
+size_t HttpClient::queuedCount() {
+    std::lock_guard<std::mutex> lock(jobMutex);
+    return jobs.size();
+}
+
+void HttpClient::startTransfer(Job&& job) {
+    CURL* curl;
+    if (!idleHandles.empty()) {
+        curl = (CURL*)idleHandles.back();
+        idleHandles.pop_back();
+        curl_easy_reset(curl);
+    } else {
+        curl = curl_easy_init();
+    }
+
+    auto* transfer = new Transfer();
+    transfer->url = std::move(job.url);
+    transfer->result.callback = std::move(job.callback);
+    transfer->options = std::move(job.options);
+
+    if (!curl) {
+        transfer->result.response.error = "Failed to init curl";
+        if (transfer->options.onComplete) transfer->options.onComplete(transfer->result.response);
+        std::lock_guard<std::mutex> lock(completedMutex);
+        completed.push_back(std::move(transfer->result));
+        delete transfer;
+        return;
+    }
+    transfer->easy = curl;
+
+    curl_easy_setopt(curl, CURLOPT_URL, transfer->url.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeBody);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, transfer);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, headerCallback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &transfer->result.response);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, "WebGraph3D/1.0");
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
+    curl_easy_setopt(curl, CURLOPT_SHARE, (CURLSH*)share);
+    // Prefer HTTP/2 over TLS and wait for an existing connection to multiplex onto
+    curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+    curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, transfer);
+
+    if (!transfer->options.headers.empty()) {
+        curl_slist* list = nullptr;
+        for (const auto& header : transfer->options.headers) list = curl_slist_append(list, header.c_str());
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, list);
+        transfer->headerList = list;
+    }
 
-    pending.push_back(std::move(req));
+    curl_multi_add_handle((CURLM*)multi, curl);
+    activeHandles.push_back(curl);
 }
 
-void HttpClient::update() {
-    for (auto it = pending.begin(); it != pending.end();) {
-        if ((*it)->done) {
-            if ((*it)->thread.joinable()) (*it)->thread.join();
-            (*it)->callback((*it)->response);
-            it = pending.erase(it);
-        } else {
-            ++it;
+void HttpClient::finishTransfer(void* easy, int result) {
+    CURL* curl = (CURL*)easy;
+    Transfer* transfer = nullptr;
+    curl_easy_getinfo(curl, CURLINFO_PRIVATE, (char**)&transfer);
+
+    if (result != CURLE_OK) {
+        transfer->result.response.error = curl_easy_strerror((CURLcode)result);
+    } else {
+        long code;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+        transfer->result.response.statusCode = (int)code;
+    }
+    long connects = 0;
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+    newConnections += connects;
+
+    if (transfer->options.onComplete) {
+        transfer->options.onComplete(transfer->result.response);
+    }
+
+    curl_multi_remove_handle((CURLM*)multi, curl);
+    activeHandles.erase(std::find(activeHandles.begin(), activeHandles.end(), easy));
+    idleHandles.push_back(curl);
+    curl_slist_free_all((curl_slist*)transfer->headerList);
+
+    {
+        std::lock_guard<std::mutex> lock(completedMutex);
+        completed.push_back(std::move(transfer->result));
+    }
+    delete transfer;
+}
+
+void HttpClient::eventLoop() {
+    CURLM* m = (CURLM*)multi;
+
+    while (!stopping) {
+        // Tasks run outside the lock so fetchAsync never waits on them
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            std::swap(running, tasks);
+        }
+        for (Task& task : running) {
+            task.work();
+            Completion done;
+            done.callback = [callback = std::move(task.callback)](HttpResponse) { callback(); };
+            std::lock_guard<std::mutex> lock(completedMutex);
+            completed.push_back(std::move(done));
         }
+        running.clear();
+
+        // Admit queued jobs up to the concurrency cap, highest priority first
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            while ((int)activeHandles.size() < maxConcurrent && !jobs.empty()) {
+                Job job = std::move(const_cast<Job&>(jobs.top()));
+                jobs.pop();
+                startTransfer(std::move(job));
+            }
+        }
+
+        int running = 0;
+        curl_multi_perform(m, &running);
+
+        CURLMsg* msg;
+        int remaining;
+        bool freedSlot = false;
+        while ((msg = curl_multi_info_read(m, &remaining))) {
+            if (msg->msg != CURLMSG_DONE) continue;
+            finishTransfer(msg->easy_handle, msg->data.result);
+            freedSlot = true;
+        }
+        // Refill freed slots right away instead of waiting on the remaining sockets
+        if (freedSlot) continue;
+
+        // Sleeps until a socket is ready, a timeout expires or fetchAsync wakes us
+        curl_multi_poll(m, nullptr, 0, 100, nullptr);
+    }
+
+    // Shutting down: drop whatever is still in flight
+    for (void* easy : activeHandles) {
+        CURL* curl = (CURL*)easy;
+        Transfer* transfer = nullptr;
+        curl_easy_getinfo(curl, CURLINFO_PRIVATE, (char**)&transfer);
+        curl_multi_remove_handle(m, curl);
+        curl_easy_cleanup(curl);
+        curl_slist_free_all((curl_slist*)transfer->headerList);
+        delete transfer;
     }
+    activeHandles.clear();
+    for (void* curl : idleHandles) curl_easy_cleanup((CURL*)curl);
+    idleHandles.clear();
 }
@@ -1,29 +1,116 @@
 #pragma once
+#include <chrono>
+#include <cstdint>
+#include <deque>
 #include <string>
 #include <functional>
 #include <thread>
 #include <atomic>
+#include <mutex>
+#include <queue>
+#include <vector>
+#include <unordered_map>
 
 struct HttpResponse {
     int statusCode = 0;
     std::string body;
     std::string error;
+    std::unordered_map<std::string, std::string> headers; // Lowercase names, final response only
+
+    std::string header(const std::string& name) const {
+        auto it = headers.find(name);
+        return it != headers.end() ? it->second : std::string();
+    }
+};
+
+// Requests the user asked for directly run ahead of bulk expansion
+enum class FetchPriority { Bulk, Interactive };
+
+// Receives 2xx body chunks on the network thread as they arrive. When set,
+// the body is not buffered into HttpResponse::body.
+using BodyHandler = std::function<void(const char* data, size_t len)>;
+// Runs on the network thread once the transfer is done, before the response
+// is queued for the main thread. Meant for work too heavy for the frame.
+using ResponseHandler = std::function<void(HttpResponse& response)>;
+
+struct FetchOptions {
+    FetchPriority priority = FetchPriority::Bulk;
+    std::vector<std::string> headers; // Full "Name: value" lines
+    BodyHandler onBody;
+    ResponseHandler onComplete;
 };
 
+// All transfers run on one event-loop thread driving a curl multi handle.
+// Connections, DNS results and TLS sessions are shared between transfers,
+// and HTTP/2 streams are multiplexed when the server supports it.
 class HttpClient {
 public:
-    HttpClient();
+    explicit HttpClient(int maxConcurrent = 64, int maxPerHost = 6);
     ~HttpClient();
 
-    void fetchAsync(const std::string& url, std::function<void(HttpResponse)> callback);
-    void update(); // Process completed requests on main thread
+    void fetchAsync(const std::string& url, std::function<void(HttpResponse)> callback, FetchOptions options = {});
+    // Runs work on the network thread ahead of any queued transfer, then
+    // callback on the main thread from update(). For blocking work that
+    // should not hold up the frame, such as disk reads.
+    void runAsync(std::function<void()> work, std::function<void()> callback);
+    // Runs completion callbacks on the main thread. Stops once the deadline
+    // passes (after at least one callback) and picks up the rest next time.
+    void update(std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max());
+
+    size_t queuedCount();
+    long connectionsOpened() const { return newConnections; }
 
 private:
-    struct PendingRequest {
-        std::thread thread;
-        std::atomic<bool> done{false};
+    struct Job {
+        uint64_t sequence; // FIFO within a priority
+        std::string url;
+        std::function<void(HttpResponse)> callback;
+        FetchOptions options;
+    };
+    struct JobOrder {
+        bool operator()(const Job& a, const Job& b) const {
+            if (a.options.priority != b.options.priority) return a.options.priority < b.options.priority;
+            return a.sequence > b.sequence;
+        }
+    };
+    struct Task {
+        std::function<void()> work;
+        std::function<void()> callback;
+    };
+    struct Completion {
         HttpResponse response;
         std::function<void(HttpResponse)> callback;
     };
-    std::vector<std::unique_ptr<PendingRequest>> pending;
+    struct Transfer {
+        void* easy = nullptr;
+        void* headerList = nullptr; // curl_slist*
+        std::string url;
+        FetchOptions options;
+        Completion result;
+    };
+
+    int maxConcurrent;
+    int maxPerHost;
+    void* multi = nullptr;  // CURLM*
+    void* share = nullptr;  // CURLSH*
+    std::vector<void*> idleHandles;   // Easy handles kept for reuse (loop thread only)
+    std::vector<void*> activeHandles; // Easy handles attached to the multi handle
+
+    std::thread loopThread;
+    std::priority_queue<Job, std::vector<Job>, JobOrder> jobs;
+    std::mutex jobMutex;
+    std::vector<Task> tasks;   // Guarded by jobMutex
+    std::vector<Task> running; // Taken from tasks (loop thread only)
+    uint64_t nextSequence = 0;
+    std::atomic<bool> stopping{false};
+    std::atomic<long> newConnections{0};
+
+    std::vector<Completion> completed;
+    std::mutex completedMutex;
+    std::deque<Completion> ready; // Taken from completed but not yet delivered (main thread only)
+
+    void eventLoop();
+    static size_t writeBody(char* data, size_t size, size_t nmemb, void* userdata);
+    void startTransfer(Job&& job);
+    void finishTransfer(void* easy, int result);
 };
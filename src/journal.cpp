@@ -0,0 +1,390 @@
+#include "journal.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unistd.h>
+
+// Changing a record's layout means a new magic; old journals are refused
+static const char journalMagic[8] = {'C', 'X', 'J', 'R', 'N', 'L', '1', '\0'};
+
+enum class RecordType : uint8_t {
+    Url = 1,      // ref, bytes
+    NodeAdded,    // url ref, x, y, z
+    EdgeAdded,    // from url ref, to url ref
+    NodeFetched,  // url ref, status, httpCode, targetSize, link count, link refs
+    NodeDeleted,  // url ref
+    PinChanged,   // url ref, pinned
+    Cleared,
+    NodeExpanded, // url ref
+};
+
+// Each record is framed as type (1 byte), payload length (4), payload and
+// a checksum (4) over everything before it, so a torn write is detected
+static const size_t recordHeader = 5;
+
+static uint32_t checksum(const char* data, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (uint8_t)data[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+Journal::~Journal() {
+    close();
+}
+
+void Journal::open(const std::string& path, bool fresh) {
+    close();
+    filePath = path;
+    truncateOnOpen = fresh;
+    fileSize = 0;
+    urlWritten.clear();
+}
+
+void Journal::close() {
+    if (fd >= 0) {
+        stopSyncThread();
+        flush(true);
+        ::close(fd);
+        fd = -1;
+    }
+    pending.clear();
+}
+
+bool Journal::openFile() {
+    // Append mode keeps writes at the end after reset() truncates the file
+    int flags = O_WRONLY | O_CREAT | O_APPEND | (truncateOnOpen ? O_TRUNC : 0);
+    fd = ::open(filePath.c_str(), flags, 0644);
+    if (fd < 0) {
+        std::cerr << "Cannot open journal " << filePath << ": " << strerror(errno) << "\n";
+        return false;
+    }
+    truncateOnOpen = false;
+    syncStopping = false;
+    syncThread = std::thread(&Journal::syncLoop, this);
+    fileSize = lseek(fd, 0, SEEK_END);
+    if (fileSize == 0) pending.insert(0, journalMagic, sizeof(journalMagic));
+    return true;
+}
+
+bool Journal::flush(bool sync) {
+    if (filePath.empty()) return false;
+    if (!pending.empty()) {
+        if (fd < 0 && !openFile()) return false;
+        size_t done = 0;
+        while (done < pending.size()) {
+            ssize_t n = write(fd, pending.data() + done, pending.size() - done);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) {
+                std::cerr << "Journal write failed: " << strerror(errno) << "\n";
+                pending.erase(0, done);
+                fileSize += done;
+                return false;
+            }
+            done += n;
+        }
+        fileSize += done;
+        pending.clear();
+        unsynced = true;
+    }
+    if (sync && unsynced && fd >= 0) {
+        fdatasync(fd);
+        unsynced = false;
+    }
+    return true;
+}
+
+void Journal::update(Clock::time_point now) {
+    if (pending.empty() && !unsynced) return;
+    flush(false);
+    if (unsynced && now - lastSync >= syncInterval) {
+        requestSync();
+        lastSync = now;
+    }
+}
+
+void Journal::requestSync() {
+    {
+        std::lock_guard<std::mutex> lock(syncMutex);
+        syncRequested = true;
+    }
+    syncWake.notify_one();
+    unsynced = false;
+}
+
+void Journal::stopSyncThread() {
+    if (!syncThread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(syncMutex);
+        syncStopping = true;
+    }
+    syncWake.notify_one();
+    syncThread.join();
+    // A request the thread never got to is left to flush(true)
+    if (syncRequested) unsynced = true;
+    syncRequested = false;
+}
+
+void Journal::syncLoop() {
+    std::unique_lock<std::mutex> lock(syncMutex);
+    while (true) {
+        syncWake.wait(lock, [this] { return syncRequested || syncStopping; });
+        if (syncStopping) return; // close() syncs what is left itself
+        syncRequested = false;
+        // Requests arriving meanwhile are folded into the next round
+        lock.unlock();
+        if (fdatasync(fd) != 0) std::cerr << "Journal sync failed: " << strerror(errno) << "\n";
+        lock.lock();
+    }
+}
+
+bool Journal::reset() {
+    pending.clear();
+    urlWritten.clear();
+    unsynced = false;
+    if (fd < 0) {
+        // Never opened: the next write starts the file over
+        truncateOnOpen = true;
+        return true;
+    }
+    if (ftruncate(fd, 0) != 0) {
+        std::cerr << "Cannot truncate journal " << filePath << ": " << strerror(errno) << "\n";
+        return false;
+    }
+    // A truncation lost in a crash only replays records the snapshot already
+    // holds, so the sync can wait for the thread like any other
+    requestSync();
+    fileSize = 0;
+    pending.assign(journalMagic, sizeof(journalMagic));
+    return true;
+}
+
+uint32_t Journal::urlRef(const Graph& graph, UrlId id) {
+    if (id >= urlWritten.size()) urlWritten.resize(graph.urls.size());
+    if (!urlWritten[id]) {
+        urlWritten[id] = true;
+        std::string_view url = graph.urls.str(id);
+        begin((uint8_t)RecordType::Url);
+        putU32(id);
+        put(url.data(), url.size());
+        end();
+    }
+    return id;
+}
+
+void Journal::begin(uint8_t type) {
+    recordStart = pending.size();
+    pending.push_back((char)type);
+    pending.append(4, '\0'); // Length, filled in by end()
+}
+
+void Journal::end() {
+    uint32_t len = pending.size() - recordStart - recordHeader;
+    memcpy(&pending[recordStart + 1], &len, 4);
+    putU32(checksum(pending.data() + recordStart, pending.size() - recordStart));
+}
+
+void Journal::nodeAdded(const Graph& graph, int idx) {
+    uint32_t url = urlRef(graph, graph.nodes[idx].url);
+    float pos[3] = {graph.sim.x[idx], graph.sim.y[idx], graph.sim.z[idx]};
+    begin((uint8_t)RecordType::NodeAdded);
+    putU32(url);
+    put(pos, sizeof(pos));
+    end();
+}
+
+void Journal::edgeAdded(const Graph& graph, int from, int to) {
+    uint32_t fromUrl = urlRef(graph, graph.nodes[from].url);
+    uint32_t toUrl = urlRef(graph, graph.nodes[to].url);
+    begin((uint8_t)RecordType::EdgeAdded);
+    putU32(fromUrl);
+    putU32(toUrl);
+    end();
+}
+
+void Journal::nodeFetched(const Graph& graph, int idx) {
+    const Node& node = graph.nodes[idx];
+    uint32_t url = urlRef(graph, node.url);
+    for (UrlId link : node.links) urlRef(graph, link);
+    uint8_t status = (uint8_t)node.status;
+    int32_t httpCode = node.httpCode;
+    begin((uint8_t)RecordType::NodeFetched);
+    putU32(url);
+    put(&status, 1);
+    put(&httpCode, 4);
+    put(&node.targetSize, 4);
+    putU32(node.links.size());
+    put(node.links.data(), node.links.size() * sizeof(UrlId));
+    end();
+}
+
+void Journal::nodeDeleted(const Graph& graph, int idx) {
+    uint32_t url = urlRef(graph, graph.nodes[idx].url);
+    begin((uint8_t)RecordType::NodeDeleted);
+    putU32(url);
+    end();
+}
+
+void Journal::pinChanged(const Graph& graph, int idx) {
+    uint32_t url = urlRef(graph, graph.nodes[idx].url);
+    uint8_t pinned = graph.pinned(idx);
+    begin((uint8_t)RecordType::PinChanged);
+    putU32(url);
+    put(&pinned, 1);
+    end();
+}
+
+void Journal::nodeExpanded(const Graph& graph, int idx) {
+    uint32_t url = urlRef(graph, graph.nodes[idx].url);
+    begin((uint8_t)RecordType::NodeExpanded);
+    putU32(url);
+    end();
+}
+
+void Journal::cleared(const Graph& graph) {
+    begin((uint8_t)RecordType::Cleared);
+    end();
+}
+
+// Sequential reader over one record's payload; reads past the end fail
+struct RecordReader {
+    const char* p;
+    const char* end;
+
+    bool read(void* out, size_t len) {
+        if ((size_t)(end - p) < len) return false;
+        memcpy(out, p, len);
+        p += len;
+        return true;
+    }
+    template <typename T>
+    bool read(T& out) { return read(&out, sizeof(T)); }
+};
+
+bool Journal::replay(Graph& graph, const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return true; // Nothing journaled yet
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string data = buffer.str();
+    if (data.empty()) return true;
+    if (data.size() < sizeof(journalMagic) || memcmp(data.data(), journalMagic, sizeof(journalMagic)) != 0) {
+        std::cerr << path << " is not a journal\n";
+        return false;
+    }
+
+    GraphObserver* observer = graph.observer;
+    graph.observer = nullptr;
+
+    // Journal URL refs to the graph's own ids; a later definition of a ref wins
+    std::vector<UrlId> urls;
+    auto lookup = [&](uint32_t ref, UrlId& id) {
+        if (ref >= urls.size() || urls[ref] == UrlTable::none) return false;
+        id = urls[ref];
+        return true;
+    };
+    auto nodeFor = [&](uint32_t ref) {
+        UrlId id;
+        return lookup(ref, id) ? graph.findNodeByUrl(id) : -1;
+    };
+
+    size_t pos = sizeof(journalMagic);
+    size_t records = 0;
+    while (data.size() - pos >= recordHeader + 4) {
+        uint8_t type = data[pos];
+        uint32_t len, sum;
+        memcpy(&len, &data[pos + 1], 4);
+        if (len > data.size() - pos - recordHeader - 4) break;
+        memcpy(&sum, &data[pos + recordHeader + len], 4);
+        if (sum != checksum(&data[pos], recordHeader + len)) break;
+
+        RecordReader r{&data[pos + recordHeader], &data[pos + recordHeader + len]};
+        uint32_t ref = 0;
+        bool ok = type == (uint8_t)RecordType::Cleared || r.read(ref);
+        switch ((RecordType)type) {
+        case RecordType::Url:
+            if (!ok) break;
+            if (ref >= urls.size()) urls.resize(ref + 1, UrlTable::none);
+            urls[ref] = graph.urls.intern(std::string_view(r.p, r.end - r.p));
+            break;
+        case RecordType::NodeAdded: {
+            float p[3];
+            UrlId id;
+            if (ok && r.read(p) && lookup(ref, id) && graph.findNodeByUrl(id) < 0) {
+                int idx = graph.addNode(id, glm::vec3(p[0], p[1], p[2]));
+                graph.nodes[idx].fadeIn = 1.0f;
+            }
+            break;
+        }
+        case RecordType::EdgeAdded: {
+            uint32_t toRef;
+            if (ok && r.read(toRef)) {
+                int from = nodeFor(ref), to = nodeFor(toRef);
+                size_t before = graph.edges.size();
+                if (from >= 0 && to >= 0) graph.addEdge(from, to);
+                if (graph.edges.size() > before) graph.edges.back().fadeIn = 1.0f;
+            }
+            break;
+        }
+        case RecordType::NodeFetched: {
+            uint8_t status;
+            int32_t httpCode;
+            float targetSize;
+            uint32_t count;
+            int idx = nodeFor(ref);
+            if (!ok || idx < 0 || !r.read(status) || !r.read(httpCode) || !r.read(targetSize) || !r.read(count)) break;
+            if (status > (uint8_t)NodeStatus::Error || count > (size_t)(r.end - r.p) / 4) break;
+            Node& node = graph.nodes[idx];
+            node.status = (NodeStatus)status;
+            node.httpCode = httpCode;
+            node.targetSize = targetSize;
+            node.links.clear();
+            for (uint32_t l = 0; l < count; l++) {
+                uint32_t linkRef;
+                UrlId link;
+                r.read(linkRef);
+                if (lookup(linkRef, link)) node.links.push_back(link);
+            }
+            break;
+        }
+        case RecordType::NodeDeleted:
+            if (ok) graph.deleteNode(nodeFor(ref));
+            break;
+        case RecordType::PinChanged: {
+            uint8_t pinned;
+            int idx = nodeFor(ref);
+            if (ok && idx >= 0 && r.read(pinned)) graph.setPinned(idx, pinned);
+            break;
+        }
+        case RecordType::NodeExpanded: {
+            int idx = nodeFor(ref);
+            if (ok && idx >= 0) graph.nodes[idx].expanded = true;
+            break;
+        }
+        case RecordType::Cleared:
+            graph.clear();
+            break;
+        default:
+            break; // Unknown types are skipped, their length is known
+        }
+        pos += recordHeader + len + 4;
+        records++;
+    }
+    graph.observer = observer;
+
+    if (pos < data.size()) {
+        // A crash in the middle of a write; drop it so appends line up again
+        std::cerr << "Journal " << path << ": discarding " << data.size() - pos << " bytes after record " << records << "\n";
+        if (truncate(path.c_str(), pos) != 0) {
+            std::cerr << "Cannot truncate journal " << path << ": " << strerror(errno) << "\n";
+            return false;
+        }
+    }
+    std::cout << "Replayed " << records << " journal records from " << path << "\n";
+    return true;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include "graph.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Append-only log of graph mutations, replayed on top of the last snapshot
+// after a crash. Records are buffered in memory and written out by
+// update(), so the cost follows the rate of change rather than the size of
+// the graph. At most once per syncInterval update() has a background thread
+// fdatasync the file, so the frame never waits for the disk.
+//
+// Nodes are identified by URL. Each URL is written once per file and then
+// referred to by a number, so replay works no matter how slots were laid
+// out. Replay is idempotent: records that already hold in the graph (for
+// example after a crash between saving a snapshot and reset()) are no-ops.
+// Positions are only recorded when a node is added.
+class Journal : public GraphObserver {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    std::chrono::milliseconds syncInterval{1000};
+
+    ~Journal();
+
+    // Appends to path, or truncates it on the first write when fresh is
+    // set. Nothing touches the file before there is something to record.
+    void open(const std::string& path, bool fresh);
+    void close();
+    const std::string& path() const { return filePath; }
+
+    // Applies every intact record in path to graph and cuts off a torn tail
+    // left by a crash. A missing file counts as empty. The graph's observer
+    // is not notified.
+    static bool replay(Graph& graph, const std::string& path);
+
+    void update(Clock::time_point now = Clock::now());
+    // Writes out what is buffered; with sync set, also fdatasyncs before returning
+    bool flush(bool sync);
+    // Empties the file once a snapshot holds everything it recorded
+    bool reset();
+    // Bytes in the file plus those still buffered
+    size_t size() const { return fileSize + pending.size(); }
+
+    void nodeAdded(const Graph& graph, int idx) override;
+    void edgeAdded(const Graph& graph, int from, int to) override;
+    void nodeFetched(const Graph& graph, int idx) override;
+    void nodeDeleted(const Graph& graph, int idx) override;
+    void pinChanged(const Graph& graph, int idx) override;
+    void nodeExpanded(const Graph& graph, int idx) override;
+    void cleared(const Graph& graph) override;
+
+private:
+    std::string filePath;
+    int fd = -1;
+    bool truncateOnOpen = false;
+    size_t fileSize = 0;
+    bool unsynced = false;
+    Clock::time_point lastSync;
+    std::string pending;
+    size_t recordStart = 0;       // Offset in pending of the record being built
+    std::vector<bool> urlWritten; // By UrlId, reset with the file
+
+    // Background fdatasync; fd only changes while the thread is not running
+    std::thread syncThread;
+    std::mutex syncMutex;
+    std::condition_variable syncWake;
+    bool syncRequested = false;
+    bool syncStopping = false;
+
+    bool openFile();
+    void requestSync();
+    void stopSyncThread();
+    void syncLoop();
+    uint32_t urlRef(const Graph& graph, UrlId id);
+    void begin(uint8_t type);
+    void end();
+    void put(const void* data, size_t len) { pending.append((const char*)data, len); }
+    void putU32(uint32_t v) { put(&v, 4); }
+};
@@ -2,171 +2,112 @@
 #include "camera.h"
 #include "renderer.h"
 #include "graph.h"
-#include "physics.h"
+#include "physics_thread.h"
 #include "http_client.h"
-#include "html_parser.h"
+#include "fetch_scheduler.h"
+#include "response_cache.h"
+#include "crawler.h"
+#include "snapshot.h"
+#include "journal.h"
+#include "headless.h"
 #include "ui.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
-#include <random>
-#include <queue>
-#include <unordered_map>
 
-std::random_device rd;
-std::mt19937 rng(rd());
-
-// Queues for gradual link expansion (per-node so multiple can expand at once)
-std::unordered_map<int, std::queue<std::string>> pendingLinksPerNode;
 float linkSpawnTimer = 0.0f;
 const float linkSpawnDelay = 0.01f; // 10ms between spawns
 const float fadeSpeed = 3.0f; // fade in over ~0.3 seconds
 
-glm::vec3 randomOffset(float radius) {
-    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
-    glm::vec3 v(dist(rng), dist(rng), dist(rng));
-    return glm::normalize(v) * radius;
-}
-
-void fetchNode(Graph* graphPtr, HttpClient& http, int nodeIdx) {
-    if (nodeIdx < 0 || nodeIdx >= (int)graphPtr->nodes.size()) return;
-    Node& node = graphPtr->nodes[nodeIdx];
-    if (node.fetching) return;
-    node.fetching = true;
-
-    std::string url = node.url;
-    http.fetchAsync(url, [graphPtr, nodeIdx, url](HttpResponse resp) {
-        Graph& graph = *graphPtr;
-        // Validate node still exists and has same URL (graph might have been cleared)
-        if (nodeIdx < 0 || nodeIdx >= (int)graph.nodes.size()) return;
-        if (graph.nodes[nodeIdx].url != url) return;
-
-        Node& node = graph.nodes[nodeIdx];
-        node.fetching = false;
-
-        if (!resp.error.empty() || resp.statusCode >= 400) {
-            node.status = NodeStatus::Error;
-            node.httpCode = resp.statusCode > 0 ? resp.statusCode : -1;
-            std::cout << "Error fetching " << url << ": " << node.httpCode << "\n";
-        } else {
-            node.status = NodeStatus::Success;
-            auto links = extractLinks(resp.body, url);
-            if (links.size() > 200) links.resize(200);
-            node.links = std::move(links);
-            float logSize = std::log(1.0f + node.links.size());
-            node.targetSize = 0.4f + 0.25f * logSize * (1.0f + logSize * 0.1f);
-            std::cout << "Fetched " << url << " - " << node.links.size() << " links\n";
-        }
-    });
-}
-
-void activateNode(Graph& graph, HttpClient& http, int nodeIdx) {
-    if (nodeIdx < 0 || nodeIdx >= (int)graph.nodes.size()) return;
-    Node& node = graph.nodes[nodeIdx];
+// Main-thread time per frame for applying fetch results and spawning nodes
+const float integrationBudgetMs = 4.0f;
 
-    if (node.status == NodeStatus::Pending) {
-        // Still fetching, do nothing
-        return;
-    }
-
-    if (node.status == NodeStatus::Error) {
-        // Retry failed request
-        node.status = NodeStatus::Pending;
-        node.fetching = false;
-        fetchNode(&graph, http, nodeIdx);
-        std::cout << "Retrying: " << node.url << "\n";
-        return;
-    }
-
-    // Success - expand if not already
-    if (node.expanded) return;
-    node.expanded = true;
-
-    // Queue all links for gradual expansion (per-node queue)
-    auto& queue = pendingLinksPerNode[nodeIdx];
-    for (const auto& link : node.links) {
-        queue.push(link);
-    }
-    std::cout << "Queued: " << node.url << " (" << node.links.size() << " links)\n";
-}
+// How far ahead V reaches when selecting everything in view
+const float selectRange = 30.0f;
 
-void processPendingLinks(Graph& graph, HttpClient& http, float dt) {
-    // Update fade-in and size interpolation for all nodes
+// Fade-in and size interpolation for nodes and edges
+void updateFades(Graph& graph, PhysicsThread& simulation, float dt) {
     const float sizeSpeed = 4.0f; // smooth size transitions
     for (size_t i = 0; i < graph.nodes.size(); i++) {
+        if (!graph.alive(i)) continue;
         if (graph.nodes[i].fadeIn < 1.0f) {
             graph.nodes[i].fadeIn = std::min(1.0f, graph.nodes[i].fadeIn + fadeSpeed * dt);
         }
         // Smooth size interpolation
-        float diff = graph.nodes[i].targetSize - graph.nodes[i].size;
+        float diff = graph.nodes[i].targetSize - graph.sim.size[i];
+        if (diff == 0.0f) continue;
         if (std::abs(diff) > 0.001f) {
-            graph.nodes[i].size += diff * sizeSpeed * dt;
+            graph.sim.size[i] += diff * sizeSpeed * dt;
         } else {
-            graph.nodes[i].size = graph.nodes[i].targetSize;
+            graph.sim.size[i] = graph.nodes[i].targetSize;
         }
+        simulation.touch(i, PhysicsThread::FieldSize);
     }
     for (size_t i = 0; i < graph.edges.size(); i++) {
         if (graph.edges[i].fadeIn < 1.0f) {
             graph.edges[i].fadeIn = std::min(1.0f, graph.edges[i].fadeIn + fadeSpeed * dt);
         }
     }
+}
 
-    if (pendingLinksPerNode.empty()) return;
-
-    linkSpawnTimer += dt;
-    if (linkSpawnTimer < linkSpawnDelay) return;
-    linkSpawnTimer -= linkSpawnDelay;
-
-    // Process one link from each active node queue (copy keys to avoid iterator issues)
-    std::vector<int> parentKeys;
-    for (auto& [k, v] : pendingLinksPerNode) {
-        parentKeys.push_back(k);
+// Journal size at which it is folded into a new snapshot
+const size_t journalCompactBytes = 64 << 20;
+
+// Swaps in a saved graph. With replay, changes journaled since the snapshot
+// are applied on top (a journal without a snapshot is fine too); without,
+// they are discarded. Fetches still in flight belong to the old graph and
+// are dropped when they complete; nodes saved mid-fetch are refetched.
+bool loadGraph(Graph& graph, Crawler& crawler, Journal& journal, const std::string& path, bool replay) {
+    auto start = std::chrono::steady_clock::now();
+    // Loading replaces the graph wholesale, which the journal cannot express
+    GraphObserver* observer = graph.observer;
+    graph.observer = nullptr;
+    bool ok = true;
+    if (replay && !std::filesystem::exists(path) && std::filesystem::exists(journal.path())) {
+        graph.clear(); // Never saved: the journal has everything
+    } else {
+        ok = loadSnapshot(graph, path);
     }
+    if (ok && replay) ok = Journal::replay(graph, journal.path());
+    graph.observer = observer;
+    if (!ok) return false;
+    if (!replay) journal.reset();
+
+    crawler.clearPending();
+    crawler.fetchPendingNodes();
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Loaded " << graph.nodeCount() << " nodes, " << graph.edges.size() << " edges from "
+              << path << " in " << ms << " ms\n";
+    return true;
+}
 
-    for (int parentIdx : parentKeys) {
-        auto it = pendingLinksPerNode.find(parentIdx);
-        if (it == pendingLinksPerNode.end()) continue;
-
-        auto& queue = it->second;
-        if (queue.empty()) {
-            pendingLinksPerNode.erase(parentIdx);
-            continue;
-        }
-
-        // Validate parent still exists
-        if (parentIdx < 0 || parentIdx >= (int)graph.nodes.size()) {
-            pendingLinksPerNode.erase(parentIdx);
-            continue;
-        }
-
-        std::string url = queue.front();
-        queue.pop();
-
-        if (queue.empty()) {
-            pendingLinksPerNode.erase(parentIdx);
-        }
-
-        // Check if this URL already exists as a node
-        int existingIdx = graph.findNodeByUrl(url);
-        if (existingIdx >= 0) {
-            // Link to existing node
-            graph.addEdge(parentIdx, existingIdx);
-        } else {
-            // Create new node - get position before modifying graph
-            glm::vec3 parentPos = graph.nodes[parentIdx].position;
-            glm::vec3 pos = parentPos + randomOffset(6.0f);
-            int childIdx = graph.addNode(url, pos);
-            graph.addEdge(parentIdx, childIdx);
-            fetchNode(&graph, http, childIdx);
-        }
-    }
+// Writes a snapshot and empties the journal it now covers
+bool saveGraph(const Graph& graph, Journal& journal, const std::string& path) {
+    if (!saveSnapshot(graph, path)) return false;
+    journal.reset();
+    std::cout << "Saved " << graph.nodeCount() << " nodes to " << path << "\n";
+    return true;
 }
 
 int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0) return runHeadless(argc, argv);
+    }
+
     int width = 1280, height = 720;
+    std::string snapshotPath = defaultSnapshotPath();
+    bool loadAtStart = false;
 
-    // Parse args: -w WIDTH -h HEIGHT or WIDTHxHEIGHT
+    // Parse args: -w WIDTH -h HEIGHT or WIDTHxHEIGHT, --load SNAPSHOT
     for (int i = 1; i < argc; i++) {
         std::string arg = argv[i];
-        if (arg == "-w" && i + 1 < argc) {
+        if (arg == "--load" && i + 1 < argc) {
+            snapshotPath = argv[++i];
+            loadAtStart = true;
+        } else if (arg == "-w" && i + 1 < argc) {
             width = std::stoi(argv[++i]);
         } else if (arg == "-h" && i + 1 < argc) {
             height = std::stoi(argv[++i]);
@@ -191,10 +132,33 @@ int main(int argc, char* argv[]) {
     Graph graph;
     graph.nodes.reserve(1000);
     graph.edges.reserve(5000);
-    Physics physics;
+    // Steps the layout on its own thread; started once the graph is loaded
+    PhysicsThread simulation;
+    // Written from the network thread, so it has to outlive the HttpClient
+    ResponseCache responseCache;
+    responseCache.open();
     HttpClient http;
+    FetchScheduler fetcher(http);
+    Crawler crawler(graph, fetcher, &responseCache);
     UI ui;
 
+    // Every change is journaled next to the snapshot, to be replayed by the
+    // next --load if this session ends before it is saved
+    Journal journal;
+    journal.open(snapshotPath + ".journal", !loadAtStart);
+    if (loadAtStart && !loadGraph(graph, crawler, journal, snapshotPath, true)) {
+        return 1;
+    }
+    std::error_code ec;
+    if (!loadAtStart && std::filesystem::file_size(journal.path(), ec) > 0 && !ec) {
+        std::cout << journal.path() << " holds unsaved changes from an earlier session. Restart with --load "
+                  << snapshotPath << " to recover them; they are overwritten once this session changes the graph.\n";
+    }
+    GraphObserverList observers;
+    observers.list = {&journal, &simulation};
+    graph.observer = &observers;
+    simulation.start();
+
     Uint64 lastTime = SDL_GetPerformanceCounter();
     float freq = (float)SDL_GetPerformanceFrequency();
 
@@ -203,21 +167,57 @@ int main(int argc, char* argv[]) {
     std::cout << "  Shift - Move faster\n";
     std::cout << "  Enter - Open address bar, type URL, Enter to submit\n";
     std::cout << "  Esc - Cancel address bar\n";
-    std::cout << "  E - Expand selected node (show links)\n";
+    std::cout << "  E - Expand selected node(s) (show links)\n";
     std::cout << "  X - Expand all nodes (explosive)\n";
-    std::cout << "  Q - Delete selected node\n";
+    std::cout << "  Q - Delete selected node(s)\n";
     std::cout << "  R - Visibility menu (toggle nodes/links/labels)\n";
     std::cout << "  Left Click - Drag node\n";
-    std::cout << "  Right Click - Pin/unpin node (lock position)\n";
+    std::cout << "  Ctrl+Left Click - Add/remove node from selection (on empty space: clear it)\n";
+    std::cout << "  V - Select all nodes in view (up to " << selectRange << " units away)\n";
+    std::cout << "  Right Click - Pin/unpin node(s) (lock position)\n";
     std::cout << "  Delete - Clear all nodes\n";
+    std::cout << "  F5 - Save snapshot (" << snapshotPath << ")\n";
+    std::cout << "  F9 - Load snapshot\n";
     std::cout << "  F11 - Toggle fullscreen\n";
     std::cout << "  Ctrl+Q - Quit\n\n";
 
-    int draggingNode = -1;
+    NodeHandle draggingNode;
     float dragDistance = 0.0f;
     glm::vec3 lastDragPos(0.0f);
     glm::vec3 dragVelocity(0.0f);
 
+    // Node under the crosshair
+    auto pick = [&]() {
+        return graph.raycast(camera.position, camera.getForward(), 100.0f, &simulation.spatialIndex());
+    };
+
+    // Multi-selection; while it is non-empty E, Q and right click act on it
+    // instead of the node under the crosshair
+    std::vector<NodeHandle> selection;
+    std::vector<int> selectedSlots;
+    // Drops handles to deleted nodes and returns the slots of the rest
+    auto resolveSelection = [&]() -> const std::vector<int>& {
+        selectedSlots.clear();
+        size_t kept = 0;
+        for (const NodeHandle& h : selection) {
+            int idx = graph.resolve(h);
+            if (idx < 0) continue;
+            selection[kept++] = h;
+            selectedSlots.push_back(idx);
+        }
+        selection.resize(kept);
+        return selectedSlots;
+    };
+    auto toggleSelected = [&](int idx) {
+        NodeHandle h = graph.handle(idx);
+        auto it = std::find(selection.begin(), selection.end(), h);
+        if (it != selection.end()) {
+            selection.erase(it);
+        } else {
+            selection.push_back(h);
+        }
+    };
+
     while (!window.shouldClose()) {
         Uint64 now = SDL_GetPerformanceCounter();
         float dt = (now - lastTime) / freq;
@@ -241,34 +241,77 @@ int main(int argc, char* argv[]) {
                     if (event.key.keysym.sym == SDLK_q && (event.key.keysym.mod & KMOD_CTRL)) {
                         window.close();
                     } else if (event.key.keysym.sym == SDLK_q) {
-                        int selected = graph.raycast(camera.position, camera.getForward());
-                        if (selected >= 0) {
-                            pendingLinksPerNode.erase(selected);
-                            graph.deleteNode(selected);
+                        if (!resolveSelection().empty()) {
+                            for (int idx : selectedSlots) {
+                                crawler.forget(idx);
+                                graph.deleteNode(idx);
+                            }
+                            std::cout << "Deleted " << selectedSlots.size() << " selected nodes\n";
+                            selection.clear();
+                        } else {
+                            int selected = pick();
+                            if (selected >= 0) {
+                                crawler.forget(selected);
+                                graph.deleteNode(selected);
+                            }
                         }
+                    } else if (event.key.keysym.sym == SDLK_v) {
+                        float aspect = (float)window.getWidth() / std::max(window.getHeight(), 1);
+                        glm::mat4 proj = glm::perspective(glm::radians(camera.fov), aspect, 0.1f, selectRange);
+                        Frustum volume(proj * camera.getViewMatrix());
+                        std::vector<int> found;
+                        graph.select(volume, found, &simulation.spatialIndex());
+                        selection.clear();
+                        for (int idx : found) selection.push_back(graph.handle(idx));
+                        std::cout << "Selected " << selection.size() << " nodes\n";
                     } else if (event.key.keysym.sym == SDLK_DELETE || event.key.keysym.sym == SDLK_BACKSPACE) {
                         graph.clear();
-                        pendingLinksPerNode.clear();
+                        crawler.clearPending();
                         std::cout << "Cleared all nodes\n";
+                    } else if (event.key.keysym.sym == SDLK_F5) {
+                        saveGraph(graph, journal, snapshotPath);
+                    } else if (event.key.keysym.sym == SDLK_F9) {
+                        draggingNode = NodeHandle();
+                        loadGraph(graph, crawler, journal, snapshotPath, false);
+                        simulation.reset();
+                    }
+                } else if (event.type == SDL_MOUSEBUTTONDOWN && event.button.button == SDL_BUTTON_LEFT && !ui.menuOpen &&
+                           (SDL_GetModState() & KMOD_CTRL)) {
+                    int selected = pick();
+                    if (selected >= 0) {
+                        toggleSelected(selected);
+                    } else {
+                        selection.clear();
                     }
+                    std::cout << "Selected " << resolveSelection().size() << " nodes\n";
                 } else if (event.type == SDL_MOUSEBUTTONDOWN && event.button.button == SDL_BUTTON_LEFT && !ui.menuOpen) {
-                    int selected = graph.raycast(camera.position, camera.getForward());
+                    int selected = pick();
                     if (selected >= 0) {
-                        draggingNode = selected;
-                        dragDistance = glm::length(graph.nodes[selected].position - camera.position);
-                        lastDragPos = graph.nodes[selected].position;
+                        draggingNode = graph.handle(selected);
+                        dragDistance = glm::length(graph.position(selected) - camera.position);
+                        lastDragPos = graph.position(selected);
                         dragVelocity = glm::vec3(0.0f);
                     }
                 } else if (event.type == SDL_MOUSEBUTTONUP && event.button.button == SDL_BUTTON_LEFT) {
-                    if (draggingNode >= 0 && draggingNode < (int)graph.nodes.size()) {
-                        graph.nodes[draggingNode].velocity = dragVelocity;
+                    int dragged = graph.resolve(draggingNode);
+                    if (dragged >= 0) {
+                        graph.setVelocity(dragged, dragVelocity);
+                        simulation.touch(dragged, PhysicsThread::FieldVelocity);
                     }
-                    draggingNode = -1;
+                    draggingNode = NodeHandle();
                 } else if (event.type == SDL_MOUSEBUTTONDOWN && event.button.button == SDL_BUTTON_RIGHT && !ui.menuOpen) {
-                    int selected = graph.raycast(camera.position, camera.getForward());
-                    if (selected >= 0) {
-                        graph.nodes[selected].pinned = !graph.nodes[selected].pinned;
-                        std::cout << (graph.nodes[selected].pinned ? "Pinned: " : "Unpinned: ") << graph.nodes[selected].url << "\n";
+                    if (!resolveSelection().empty()) {
+                        // Pin them all unless all of them are pinned already
+                        bool pin = std::any_of(selectedSlots.begin(), selectedSlots.end(),
+                                               [&](int idx) { return !graph.pinned(idx); });
+                        for (int idx : selectedSlots) graph.setPinned(idx, pin);
+                        std::cout << (pin ? "Pinned " : "Unpinned ") << selectedSlots.size() << " selected nodes\n";
+                    } else {
+                        int selected = pick();
+                        if (selected >= 0) {
+                            graph.setPinned(selected, !graph.pinned(selected));
+                            std::cout << (graph.pinned(selected) ? "Pinned: " : "Unpinned: ") << graph.url(selected) << "\n";
+                        }
                     }
                 } else if (event.type == SDL_MOUSEMOTION && !ui.menuOpen) {
                     camera.processMouse(event.motion.xrel, event.motion.yrel);
@@ -278,11 +321,8 @@ int main(int argc, char* argv[]) {
 
         // Handle URL submission
         if (ui.hasSubmittedUrl()) {
-            std::string url = ui.consumeSubmittedUrl();
             glm::vec3 spawnPos = camera.position + camera.getForward() * 5.0f;
-            int nodeIdx = graph.addNode(url, spawnPos);
-            fetchNode(&graph, http, nodeIdx);
-            std::cout << "Added node: " << url << "\n";
+            crawler.addSeed(ui.consumeSubmittedUrl(), spawnPos, FetchPriority::Interactive);
         }
 
         // Keyboard input for movement
@@ -293,9 +333,13 @@ int main(int argc, char* argv[]) {
             // Check for E to activate node (expand or retry)
             static bool eWasPressed = false;
             if (keys[SDL_SCANCODE_E] && !eWasPressed) {
-                int selected = graph.raycast(camera.position, camera.getForward());
-                if (selected >= 0) {
-                    activateNode(graph, http, selected);
+                if (!resolveSelection().empty()) {
+                    for (int idx : selectedSlots) crawler.activate(idx, FetchPriority::Interactive);
+                } else {
+                    int selected = pick();
+                    if (selected >= 0) {
+                        crawler.activate(selected, FetchPriority::Interactive);
+                    }
                 }
             }
             eWasPressed = keys[SDL_SCANCODE_E];
@@ -303,51 +347,76 @@ int main(int argc, char* argv[]) {
             // Check for X to expand all nodes (explosive)
             static bool xWasPressed = false;
             if (keys[SDL_SCANCODE_X] && !xWasPressed) {
-                int count = graph.nodes.size();
-                for (int i = 0; i < count; i++) {
-                    activateNode(graph, http, i);
+                int slots = graph.nodes.size();
+                for (int i = 0; i < slots; i++) {
+                    crawler.activate(i, FetchPriority::Bulk);
                 }
-                std::cout << "Expanding all " << count << " nodes\n";
+                std::cout << "Expanding all " << graph.nodeCount() << " nodes\n";
             }
             xWasPressed = keys[SDL_SCANCODE_X];
         }
 
         // Drag node - keep at same distance, move with crosshair
-        if (draggingNode >= 0 && draggingNode < (int)graph.nodes.size()) {
+        int dragged = graph.resolve(draggingNode);
+        if (dragged >= 0) {
             glm::vec3 newPos = camera.position + camera.getForward() * dragDistance;
             // Track velocity for throwing
             if (dt > 0.0001f) {
                 dragVelocity = (newPos - lastDragPos) / dt;
             }
             lastDragPos = newPos;
-            graph.nodes[draggingNode].position = newPos;
-            graph.nodes[draggingNode].velocity = glm::vec3(0.0f); // Stop physics while dragging
+            graph.setPosition(dragged, newPos);
+            graph.setVelocity(dragged, glm::vec3(0.0f)); // Stop physics while dragging
+            simulation.touch(dragged, PhysicsThread::FieldPosition | PhysicsThread::FieldVelocity);
         }
 
         // Update
-        http.update();
-        processPendingLinks(graph, http, dt);
-        physics.update(graph, dt);
+        // Fetch results and node spawning share a time budget so heavy crawls don't hitch
+        auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::microseconds((int)(integrationBudgetMs * 1000.0f));
+        fetcher.update(deadline);
+        updateFades(graph, simulation, dt);
+        if (crawler.hasPendingLinks()) {
+            linkSpawnTimer += dt;
+            if (linkSpawnTimer >= linkSpawnDelay) {
+                linkSpawnTimer -= linkSpawnDelay;
+                crawler.spawnPending(deadline);
+            }
+        }
+        // Send this frame's changes, take the newest positions
+        simulation.sync(graph);
+
+        journal.update();
+        if (journal.size() > journalCompactBytes) saveGraph(graph, journal, snapshotPath);
 
         // Find selected node for highlighting
         int selectedNode = -1;
         if (!ui.addressBarActive) {
-            selectedNode = graph.raycast(camera.position, camera.getForward());
+            selectedNode = pick();
         }
 
         // Render
         int sw = window.getWidth(), sh = window.getHeight();
         renderer.begin(camera, sw, sh);
-        renderer.renderGraph(graph, selectedNode, camera, sw, sh, dt, ui.showNodes, ui.showLinks, ui.showLabels, ui.domainColors);
+        renderer.renderGraph(graph, selectedNode, camera, sw, sh, dt, ui.showNodes, ui.showLinks, ui.showLabels, ui.domainColors,
+                             &simulation.spatialIndex(), &resolveSelection());
         renderer.renderCrosshair(sw, sh);
 
         // Stats display (if enabled)
         if (ui.showStats) {
-            int pendingCount = 0;
-            for (const auto& [k, q] : pendingLinksPerNode) {
-                pendingCount += q.size();
+            int pendingCount = crawler.pendingCount();
+            std::vector<std::string> detailLines;
+            if (simulation.settled()) {
+                detailLines.push_back("Physics: settled");
+            } else {
+                detailLines.push_back("Physics: " + std::to_string((int)std::lround(simulation.stepsPerSecond())) +
+                                      " steps/s, " + std::to_string(simulation.awakeCount()) + " awake");
+            }
+            for (const auto& [host, depth] : fetcher.hostDepths(5)) {
+                detailLines.push_back(host + ": " + std::to_string(depth) + " queued");
             }
-            renderer.renderStats(sw, sh, graph.nodes.size(), graph.edges.size(), pendingCount);
+            renderer.renderStats(sw, sh, graph.nodeCount(), graph.edges.size(), pendingCount,
+                                 fetcher.inFlightCount(), detailLines);
         }
 
         renderer.renderAddressBar(ui.addressBarText, sw, sh, ui.addressBarActive);
@@ -358,6 +427,9 @@ int main(int argc, char* argv[]) {
         window.swap();
     }
 
+    simulation.stop();
+    graph.observer = nullptr;
+    journal.close();
     renderer.shutdown();
     window.shutdown();
     return 0;
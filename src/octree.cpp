@@ -0,0 +1,190 @@
+#include "octree.h"
+#include <algorithm>
+#include <limits>
+
+void Octree::clear() {
+    cellList.clear();
+    order.clear();
+    excludedList.clear();
+    builtCount = 0;
+}
+
+void Octree::build(const float* x, const float* y, const float* z, const float* sizes, int count,
+                   const uint8_t* flags, uint8_t excludeMask) {
+    clear();
+    px = x;
+    py = y;
+    pz = z;
+    psize = sizes;
+    builtCount = count;
+
+    for (int i = 0; i < count; i++) {
+        if (flags && (flags[i] & excludeMask)) {
+            excludedList.push_back(i);
+            continue;
+        }
+        order.push_back(i);
+    }
+    int n = (int)order.size();
+    if (n == 0) return;
+    scratch.resize(n);
+
+    glm::vec3 lo = point(order[0]), hi = point(order[0]);
+    for (int idx : order) {
+        lo = glm::min(lo, point(idx));
+        hi = glm::max(hi, point(idx));
+    }
+
+    // Cubic root cell, padded slightly so points never sit exactly on the boundary
+    glm::vec3 extent = hi - lo;
+    Cell root;
+    root.center = (lo + hi) * 0.5f;
+    root.halfSize = std::max(std::max(extent.x, extent.y), extent.z) * 0.5f + 0.01f;
+    root.begin = 0;
+    root.end = n;
+    cellList.reserve(n / 2 + 1);
+    cellList.push_back(root);
+
+    subdivide(0, 0);
+}
+
+void Octree::subdivide(int cellIdx, int depth) {
+    int begin = cellList[cellIdx].begin;
+    int end = cellList[cellIdx].end;
+    glm::vec3 center = cellList[cellIdx].center;
+    float half = cellList[cellIdx].halfSize;
+
+    if (end - begin <= leafCapacity || depth >= maxDepth) {
+        glm::vec3 sum(0.0f);
+        float sizeSum = 0.0f, maxSize = 0.0f;
+        glm::vec3 lo = point(order[begin]), hi = lo;
+        for (int k = begin; k < end; k++) {
+            glm::vec3 p = point(order[k]);
+            sum += p;
+            sizeSum += psize[order[k]];
+            maxSize = std::max(maxSize, psize[order[k]]);
+            lo = glm::min(lo, p);
+            hi = glm::max(hi, p);
+        }
+        Cell& cell = cellList[cellIdx];
+        cell.count = end - begin;
+        cell.centroid = sum / (float)cell.count;
+        cell.sizeSum = sizeSum;
+        cell.lo = lo;
+        cell.hi = hi;
+        cell.maxSize = maxSize;
+        return;
+    }
+
+    // Counting sort the range by octant
+    int counts[8] = {0};
+    auto octantOf = [&](int idx) {
+        glm::vec3 p = point(idx);
+        return (p.x >= center.x ? 1 : 0) | (p.y >= center.y ? 2 : 0) | (p.z >= center.z ? 4 : 0);
+    };
+    for (int k = begin; k < end; k++) counts[octantOf(order[k])]++;
+
+    int offsets[8];
+    int running = begin;
+    for (int o = 0; o < 8; o++) {
+        offsets[o] = running;
+        running += counts[o];
+    }
+    int starts[8];
+    std::copy(offsets, offsets + 8, starts);
+    for (int k = begin; k < end; k++) {
+        int idx = order[k];
+        scratch[offsets[octantOf(idx)]++] = idx;
+    }
+    std::copy(scratch.begin() + begin, scratch.begin() + end, order.begin() + begin);
+
+    // Allocate non-empty children contiguously
+    int firstChild = (int)cellList.size();
+    int childCount = 0;
+    float childHalf = half * 0.5f;
+    for (int o = 0; o < 8; o++) {
+        if (counts[o] == 0) continue;
+        Cell child;
+        child.center = center + glm::vec3((o & 1) ? childHalf : -childHalf,
+                                          (o & 2) ? childHalf : -childHalf,
+                                          (o & 4) ? childHalf : -childHalf);
+        child.halfSize = childHalf;
+        child.begin = starts[o];
+        child.end = starts[o] + counts[o];
+        cellList.push_back(child);
+        childCount++;
+    }
+    cellList[cellIdx].firstChild = firstChild;
+    cellList[cellIdx].childCount = childCount;
+
+    glm::vec3 weighted(0.0f);
+    float sizeSum = 0.0f, maxSize = 0.0f;
+    glm::vec3 lo(std::numeric_limits<float>::max()), hi(-std::numeric_limits<float>::max());
+    for (int c = firstChild; c < firstChild + childCount; c++) {
+        subdivide(c, depth + 1);
+        weighted += cellList[c].centroid * (float)cellList[c].count;
+        sizeSum += cellList[c].sizeSum;
+        maxSize = std::max(maxSize, cellList[c].maxSize);
+        lo = glm::min(lo, cellList[c].lo);
+        hi = glm::max(hi, cellList[c].hi);
+    }
+
+    Cell& cell = cellList[cellIdx];
+    cell.count = end - begin;
+    cell.centroid = weighted / (float)cell.count;
+    cell.sizeSum = sizeSum;
+    cell.lo = lo;
+    cell.hi = hi;
+    cell.maxSize = maxSize;
+}
+
+void Octree::refit(const float* x, const float* y, const float* z, const float* sizes, int count,
+                   const uint8_t* flags, uint8_t excludeMask) {
+    px = x;
+    py = y;
+    pz = z;
+    psize = sizes;
+    if (count < builtCount) {
+        clear(); // Entries are gone, so the structure no longer describes them
+        return;
+    }
+
+    // Children always come after their parent, so a reverse sweep is bottom-up
+    const glm::vec3 empty(std::numeric_limits<float>::max());
+    for (int c = (int)cellList.size() - 1; c >= 0; c--) {
+        Cell& cell = cellList[c];
+        glm::vec3 sum(0.0f), lo = empty, hi = -empty;
+        float sizeSum = 0.0f, maxSize = 0.0f;
+        int alive = 0;
+        if (cell.firstChild < 0) {
+            for (int k = cell.begin; k < cell.end; k++) {
+                int idx = order[k];
+                if (flags && (flags[idx] & excludeMask)) continue;
+                glm::vec3 p = point(idx);
+                sum += p;
+                sizeSum += psize[idx];
+                maxSize = std::max(maxSize, psize[idx]);
+                lo = glm::min(lo, p);
+                hi = glm::max(hi, p);
+                alive++;
+            }
+        } else {
+            for (int k = cell.firstChild; k < cell.firstChild + cell.childCount; k++) {
+                const Cell& child = cellList[k];
+                if (child.count == 0) continue;
+                sum += child.centroid * (float)child.count;
+                sizeSum += child.sizeSum;
+                maxSize = std::max(maxSize, child.maxSize);
+                lo = glm::min(lo, child.lo);
+                hi = glm::max(hi, child.hi);
+                alive += child.count;
+            }
+        }
+        cell.count = alive;
+        cell.centroid = alive ? sum / (float)alive : cell.center;
+        cell.sizeSum = sizeSum;
+        cell.lo = lo;
+        cell.hi = hi;
+        cell.maxSize = maxSize;
+    }
+}
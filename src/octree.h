@@ -0,0 +1,59 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+// Point octree used for Barnes-Hut approximation and view culling. Each
+// cell stores the aggregate (count, size sum, centroid) and the tight
+// bounds of the points below it. Once points move, refit() updates those
+// without changing the cell structure.
+class Octree {
+public:
+    struct Cell {
+        glm::vec3 center{0.0f};   // Geometric center of the cube
+        float halfSize = 0.0f;
+        glm::vec3 centroid{0.0f}; // Mean position of contained points
+        float sizeSum = 0.0f;     // Sum of point sizes (mass)
+        int count = 0;
+        glm::vec3 lo{0.0f}, hi{0.0f}; // Bounds of the points, lo > hi when there are none
+        float maxSize = 0.0f;         // Largest point size, for padding the bounds
+        int firstChild = -1;      // Children are contiguous, -1 for leaves
+        int childCount = 0;
+        int begin = 0, end = 0;   // Range into indices() for this cell
+    };
+
+    int leafCapacity = 8;
+    int maxDepth = 24;
+
+    // Positions and sizes are structure-of-arrays, count entries each.
+    // Entries whose flags intersect excludeMask are left out.
+    void build(const float* x, const float* y, const float* z, const float* sizes, int count,
+               const uint8_t* flags = nullptr, uint8_t excludeMask = 0);
+    void clear();
+    // Recomputes aggregates and bounds from the current positions, children
+    // before parents. Entries that have since been excluded are left out;
+    // count must cover every index the tree was built from.
+    void refit(const float* x, const float* y, const float* z, const float* sizes, int count,
+               const uint8_t* flags = nullptr, uint8_t excludeMask = 0);
+    // Number of entries build() was given; later ones are not in the tree
+    int pointCount() const { return builtCount; }
+    // Entries below pointCount() that build() excluded. Refit cannot add
+    // them back, so a slot reused since is only found by testing these.
+    const std::vector<int>& excluded() const { return excludedList; }
+
+    const std::vector<Cell>& cells() const { return cellList; }
+    const std::vector<int>& indices() const { return order; }
+    bool empty() const { return cellList.empty(); }
+
+private:
+    std::vector<Cell> cellList;
+    std::vector<int> order;
+    std::vector<int> excludedList;
+    std::vector<int> scratch;
+    int builtCount = 0;
+
+    const float *px = nullptr, *py = nullptr, *pz = nullptr, *psize = nullptr;
+
+    glm::vec3 point(int idx) const { return glm::vec3(px[idx], py[idx], pz[idx]); }
+    void subdivide(int cellIdx, int depth);
+};
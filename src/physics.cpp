@@ -1,73 +1,361 @@
 #include "physics.h"
+#include "force_kernels.h"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
-void Physics::update(Graph& graph, float dt) {
-    auto& nodes = graph.nodes;
-    auto& edges = graph.edges;
-    size_t n = nodes.size();
+// Repulsion with soft falloff
+static const float maxRepulsionDist = 15.0f;
+
+// Nodes that forces never move
+static const uint8_t frozenMask = NodePinned | NodeDeleted | NodeAsleep;
+
+// Below this many nodes the sync overhead outweighs the parallel speedup
+static const size_t minParallelItems = 512;
+
+ThreadPool& Physics::workers() {
+    int wanted = threads > 0 ? threads : (int)std::max(1u, std::thread::hardware_concurrency());
+    if (!pool || pool->size() != wanted) {
+        pool = std::make_unique<ThreadPool>(wanted);
+    }
+    return *pool;
+}
+
+int Physics::taskCount(size_t items) const {
+    if (!pool || items < minParallelItems) return 1;
+    return pool->size();
+}
+
+void Physics::forEachTask(int tasks, const std::function<void(int)>& fn) {
+    if (tasks <= 1) {
+        fn(0);
+        return;
+    }
+    workers().run([&](int t) {
+        if (t < tasks) fn(t);
+    });
+}
+
+void Physics::reduceAccumulators(NodeArrays& sim, int tasks) {
+    int n = (int)sim.count();
+
+    // Sum in fixed task order so results do not depend on scheduling
+    forEachTask(tasks, [&](int t) {
+        int begin, end;
+        ThreadPool::splitRange(n, tasks, t, begin, end);
+        for (int i = begin; i < end; i++) {
+            if (sim.flags[i] & frozenMask) continue;
+            float sx = 0.0f, sy = 0.0f, sz = 0.0f;
+            for (int k = 0; k < tasks; k++) {
+                sx += accumulators[k].x[i];
+                sy += accumulators[k].y[i];
+                sz += accumulators[k].z[i];
+            }
+            sim.vx[i] += sx;
+            sim.vy[i] += sy;
+            sim.vz[i] += sz;
+        }
+    });
+}
+
+void Physics::applyRepulsionExact(NodeArrays& sim, float dt, int tasks) {
+    int n = (int)sim.count();
+
+    // Split rows of the i < j triangle so every task gets about the same number of pairs
+    std::vector<int> rowBounds(tasks + 1, n);
+    rowBounds[0] = 0;
+    double totalPairs = (double)n * (n - 1) / 2.0;
+    double pairsSoFar = 0.0;
+    int bound = 1;
+    for (int i = 0; i < n && bound < tasks; i++) {
+        while (bound < tasks && pairsSoFar >= totalPairs * bound / tasks) rowBounds[bound++] = i;
+        pairsSoFar += n - 1 - i;
+    }
+
+    forEachTask(tasks, [&](int t) {
+        auto& accum = accumulators[t];
+        std::fill(accum.x.begin(), accum.x.end(), 0.0f);
+        std::fill(accum.y.begin(), accum.y.end(), 0.0f);
+        std::fill(accum.z.begin(), accum.z.end(), 0.0f);
+
+        for (int i = rowBounds[t]; i < rowBounds[t + 1]; i++) {
+            repulseRow(sim.x.data(), sim.y.data(), sim.z.data(), sim.size.data(),
+                       accum.x.data(), accum.y.data(), accum.z.data(), i, i + 1, n,
+                       repulsion * dt, maxRepulsionDist);
+        }
+    });
+
+    reduceAccumulators(sim, tasks);
+}
+
+void Physics::applyRepulsionBarnesHut(NodeArrays& sim, float dt, int tasks) {
+    int n = (int)sim.count();
+    const float* xs = sim.x.data();
+    const float* ys = sim.y.data();
+    const float* zs = sim.z.data();
+    const float* sizes = sim.size.data();
+
+    octree.build(xs, ys, zs, sizes, n, sim.flags.data(), NodeDeleted);
+    if (octree.empty()) return;
+
+    const auto& cells = octree.cells();
+    const auto& order = octree.indices();
+
+    // Each node only writes its own velocity, so no accumulators are needed
+    forEachTask(tasks, [&](int t) {
+        int begin, end;
+        ThreadPool::splitRange(n, tasks, t, begin, end);
+        std::vector<int> stack;
+        stack.reserve(64);
+
+        for (int i = begin; i < end; i++) {
+            if (sim.flags[i] & frozenMask) continue;
+            glm::vec3 p(xs[i], ys[i], zs[i]);
+            float si = sizes[i];
+            glm::vec3 accum(0.0f);
+
+            stack.clear();
+            stack.push_back(0);
+            while (!stack.empty()) {
+                const Octree::Cell& cell = cells[stack.back()];
+                stack.pop_back();
+
+                // Skip cells entirely outside the repulsion cutoff
+                glm::vec3 outside = glm::max(glm::abs(p - cell.center) - glm::vec3(cell.halfSize), glm::vec3(0.0f));
+                if (glm::dot(outside, outside) > maxRepulsionDist * maxRepulsionDist) continue;
+
+                if (cell.firstChild < 0) {
+                    // Leaf: exact pairwise, same law as the exact solver
+                    for (int k = cell.begin; k < cell.end; k++) {
+                        int j = order[k];
+                        if (j == i) continue;
+                        glm::vec3 diff = p - glm::vec3(xs[j], ys[j], zs[j]);
+                        float dist = glm::length(diff);
+                        if (dist > maxRepulsionDist) continue;
+                        if (dist < 0.5f) dist = 0.5f;
+                        float combinedMass = (si + sizes[j]) * 0.5f;
+                        float strength = repulsion * combinedMass / (dist * dist + 1.0f);
+                        accum += (diff / dist) * strength;
+                    }
+                    continue;
+                }
+
+                // Far enough away (and not containing us): treat the cell as one body.
+                // Summing (si + sj) / 2 over the cell gives (si * count + sizeSum) / 2.
+                glm::vec3 diff = p - cell.centroid;
+                float dist = glm::length(diff);
+                bool inside = outside.x == 0.0f && outside.y == 0.0f && outside.z == 0.0f;
+                if (!inside && cell.halfSize * 2.0f < theta * dist) {
+                    // Cells straddling the cutoff only contribute the fraction of
+                    // their extent that lies inside it
+                    float radius = cell.halfSize * 1.7320508f;
+                    float nearDist = dist - radius;
+                    float cutoffWeight = std::min(1.0f, (maxRepulsionDist - nearDist) / (2.0f * radius));
+                    if (cutoffWeight <= 0.0f) continue;
+                    if (dist < 0.5f) dist = 0.5f;
+                    float combinedMass = (si * cell.count + cell.sizeSum) * 0.5f * cutoffWeight;
+                    float strength = repulsion * combinedMass / (dist * dist + 1.0f);
+                    accum += (diff / dist) * strength;
+                    continue;
+                }
+
+                for (int c = cell.firstChild; c < cell.firstChild + cell.childCount; c++) {
+                    stack.push_back(c);
+                }
+            }
 
-    // Repulsion with soft falloff
-    const float maxRepulsionDist = 15.0f;
+            sim.vx[i] += accum.x * dt;
+            sim.vy[i] += accum.y * dt;
+            sim.vz[i] += accum.z * dt;
+        }
+    });
+}
+
+void Physics::applySprings(NodeArrays& sim, const std::vector<Edge>& edges, float dt, int tasks) {
+    int n = (int)sim.count();
+    int edgeCount = (int)edges.size();
+
+    // Edges share endpoints, so each task accumulates into its own buffer
+    forEachTask(tasks, [&](int t) {
+        auto& accum = accumulators[t];
+        std::fill(accum.x.begin(), accum.x.end(), 0.0f);
+        std::fill(accum.y.begin(), accum.y.end(), 0.0f);
+        std::fill(accum.z.begin(), accum.z.end(), 0.0f);
+
+        int begin, end;
+        ThreadPool::splitRange(edgeCount, tasks, t, begin, end);
+        for (int e = begin; e < end; e++) {
+            const Edge& edge = edges[e];
+            int a = edge.from, b = edge.to;
+            if (a < 0 || a >= n) continue;
+            if (b < 0 || b >= n) continue;
+            if ((sim.flags[a] & frozenMask) && (sim.flags[b] & frozenMask)) continue;
 
-    for (size_t i = 0; i < n; i++) {
-        for (size_t j = i + 1; j < n; j++) {
-            glm::vec3 diff = nodes[i].position - nodes[j].position;
+            glm::vec3 diff(sim.x[b] - sim.x[a], sim.y[b] - sim.y[a], sim.z[b] - sim.z[a]);
             float dist = glm::length(diff);
+            if (dist < 0.1f) continue;
 
-            if (dist > maxRepulsionDist) continue;
-            if (dist < 0.5f) dist = 0.5f; // Soft minimum
+            // Combined mass based on node sizes (more links = bigger = more pull)
+            float combinedMass = (sim.size[a] + sim.size[b]) * 0.5f;
+            // Force weakens with distance
+            float distanceFactor = 1.0f / (1.0f + dist * 0.1f);
 
-            // Combined mass - bigger nodes (more links) repel stronger
-            float combinedMass = (nodes[i].size + nodes[j].size) * 0.5f;
+            float displacement = dist - edge.restLength;
+            glm::vec3 force = (diff / dist) * displacement * springStrength * combinedMass * distanceFactor * dt;
+
+            accum.x[a] += force.x; accum.y[a] += force.y; accum.z[a] += force.z;
+            accum.x[b] -= force.x; accum.y[b] -= force.y; accum.z[b] -= force.z;
+        }
+    });
+
+    reduceAccumulators(sim, tasks);
+}
 
-            // Inverse linear falloff (gentler than inverse square)
-            float strength = repulsion * combinedMass / (dist * dist + 1.0f);
-            glm::vec3 force = (diff / dist) * strength * dt;
+void Physics::integrate(NodeArrays& sim, float dt, int tasks) {
+    int n = (int)sim.count();
 
-            if (!nodes[i].pinned) nodes[i].velocity += force;
-            if (!nodes[j].pinned) nodes[j].velocity -= force;
+    forEachTask(tasks, [&](int t) {
+        int begin, end;
+        ThreadPool::splitRange(n, tasks, t, begin, end);
+
+        // Stop pinned nodes, then integrate the whole range in one kernel.
+        // Deleted slots have zero velocity, so they stay parked.
+        for (int i = begin; i < end; i++) {
+            if (sim.flags[i] & frozenMask) {
+                sim.vx[i] = sim.vy[i] = sim.vz[i] = 0.0f;
+            }
+        }
+        integrateRange(sim.x.data(), sim.y.data(), sim.z.data(), sim.vx.data(), sim.vy.data(), sim.vz.data(),
+                       begin, end, drag, maxSpeed, dt);
+
+        // Put nodes that stayed slow to sleep and tally the rest
+        TaskStats& stats = taskStats[t];
+        stats.energy = 0.0f;
+        stats.awake = stats.asleep = 0;
+        stats.fast.clear();
+        float sleepSpeed2 = sleepSpeed * sleepSpeed, wakeSpeed2 = wakeSpeed * wakeSpeed;
+        for (int i = begin; i < end; i++) {
+            if (sim.flags[i] & (NodePinned | NodeDeleted)) continue;
+            if (sim.flags[i] & NodeAsleep) {
+                stats.asleep++;
+                continue;
+            }
+            float speed2 = sim.vx[i] * sim.vx[i] + sim.vy[i] * sim.vy[i] + sim.vz[i] * sim.vz[i];
+            if (speed2 >= sleepSpeed2) {
+                calmSteps[i] = 0;
+            } else if (++calmSteps[i] >= sleepSteps) {
+                sim.flags[i] |= NodeAsleep;
+                sim.vx[i] = sim.vy[i] = sim.vz[i] = 0.0f;
+                stats.asleep++;
+                continue;
+            }
+            stats.energy += 0.5f * sim.size[i] * speed2;
+            stats.awake++;
+            if (speed2 > wakeSpeed2) stats.fast.push_back(i);
         }
+    });
+}
+
+void Physics::wake(NodeArrays& sim, int idx) {
+    if (idx < 0 || idx >= (int)sim.count()) return;
+    sim.flags[idx] &= ~NodeAsleep;
+    if (idx < (int)calmSteps.size()) calmSteps[idx] = 0;
+}
+
+void Physics::wakeNeighbours(NodeArrays& sim, const std::vector<Edge>& edges, int tasks) {
+    int n = (int)sim.count();
+    for (int t = 0; t < tasks; t++) {
+        for (int i : taskStats[t].fast) fastNodes[i] = 1;
     }
 
-    // Spring forces on edges - stronger for bigger nodes (like gravity)
-    for (auto& edge : edges) {
-        if (edge.from < 0 || edge.from >= (int)n) continue;
-        if (edge.to < 0 || edge.to >= (int)n) continue;
-        Node& a = nodes[edge.from];
-        Node& b = nodes[edge.to];
-
-        glm::vec3 diff = b.position - a.position;
-        float dist = glm::length(diff);
-        if (dist < 0.1f) continue;
-
-        // Combined mass based on node sizes (more links = bigger = more pull)
-        float combinedMass = (a.size + b.size) * 0.5f;
-        // Force weakens with distance
-        float distanceFactor = 1.0f / (1.0f + dist * 0.1f);
-
-        float displacement = dist - edge.restLength;
-        glm::vec3 force = (diff / dist) * displacement * springStrength * combinedMass * distanceFactor * dt;
-
-        if (!a.pinned) a.velocity += force;
-        if (!b.pinned) b.velocity -= force;
+    // Along edges
+    for (const Edge& edge : edges) {
+        int a = edge.from, b = edge.to;
+        if (a < 0 || a >= n || b < 0 || b >= n) continue;
+        if (fastNodes[a] && (sim.flags[b] & NodeAsleep)) wake(sim, b);
+        if (fastNodes[b] && (sim.flags[a] & NodeAsleep)) wake(sim, a);
     }
 
-    // Apply drag and integrate
-    for (auto& node : nodes) {
-        if (node.pinned) {
-            node.velocity = glm::vec3(0.0f); // Stop pinned nodes
-            continue;
+    // Within wakeRadius, through the tree
+    const auto& cells = octree.cells();
+    const auto& order = octree.indices();
+    float radius2 = wakeRadius * wakeRadius;
+    for (int t = 0; t < tasks; t++) {
+        for (int i : taskStats[t].fast) {
+            fastNodes[i] = 0;
+            if (cells.empty()) continue;
+            glm::vec3 p(sim.x[i], sim.y[i], sim.z[i]);
+            wakeStack.clear();
+            wakeStack.push_back(0);
+            while (!wakeStack.empty()) {
+                const Octree::Cell& cell = cells[wakeStack.back()];
+                wakeStack.pop_back();
+                if (cell.count == 0) continue;
+                glm::vec3 outside = glm::max(glm::max(cell.lo - p, p - cell.hi), glm::vec3(0.0f));
+                if (glm::dot(outside, outside) > radius2) continue;
+                if (cell.firstChild < 0) {
+                    for (int k = cell.begin; k < cell.end; k++) {
+                        int j = order[k];
+                        if (j >= n || !(sim.flags[j] & NodeAsleep)) continue;
+                        glm::vec3 diff = p - glm::vec3(sim.x[j], sim.y[j], sim.z[j]);
+                        if (glm::dot(diff, diff) <= radius2) wake(sim, j);
+                    }
+                    continue;
+                }
+                for (int c = cell.firstChild; c < cell.firstChild + cell.childCount; c++) wakeStack.push_back(c);
+            }
         }
+    }
+}
+
+void Physics::update(Graph& graph, float dt) {
+    step(graph.sim, graph.edges, dt);
+}
 
-        // Drag force opposes velocity, proportional to speed
-        node.velocity -= node.velocity * drag * dt;
+void Physics::step(NodeArrays& sim, const std::vector<Edge>& edges, float dt) {
+    size_t n = sim.count();
+    workers();
+    int tasks = taskCount(n);
 
-        float speed = glm::length(node.velocity);
-        if (speed > maxSpeed) {
-            node.velocity = (node.velocity / speed) * maxSpeed;
-        }
+    accumulators.resize(tasks);
+    for (auto& accum : accumulators) {
+        accum.x.resize(n);
+        accum.y.resize(n);
+        accum.z.resize(n);
+    }
+    taskStats.resize(tasks);
+    calmSteps.resize(n, 0);
+    fastNodes.resize(n, 0);
+
+    if (repulsionMode == RepulsionMode::BarnesHut) {
+        applyRepulsionBarnesHut(sim, dt, tasks);
+    } else {
+        applyRepulsionExact(sim, dt, tasks);
+    }
+
+    // Spring forces on edges - stronger for bigger nodes (like gravity)
+    applySprings(sim, edges, dt, tasks);
+
+    // Apply drag and integrate
+    integrate(sim, dt, tasks);
+
+    // Keep the spatial index in step with the new positions. The tree built
+    // for repulsion only needs its bounds refitted.
+    if (repulsionMode == RepulsionMode::BarnesHut) {
+        octree.refit(sim.x.data(), sim.y.data(), sim.z.data(), sim.size.data(), n, sim.flags.data(), NodeDeleted);
+    } else {
+        octree.build(sim.x.data(), sim.y.data(), sim.z.data(), sim.size.data(), n, sim.flags.data(), NodeDeleted);
+    }
 
-        node.position += node.velocity * dt;
+    energy = 0.0f;
+    awake = 0;
+    int asleep = 0;
+    bool anyFast = false;
+    for (const TaskStats& stats : taskStats) {
+        energy += stats.energy;
+        awake += stats.awake;
+        asleep += stats.asleep;
+        anyFast |= !stats.fast.empty();
     }
+    if (asleep > 0 && anyFast) wakeNeighbours(sim, edges, tasks);
 }
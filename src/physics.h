@@ -1,5 +1,11 @@
 #pragma once
 #include "graph.h"
+#include "octree.h"
+#include "thread_pool.h"
+#include <limits>
+#include <memory>
+
+enum class RepulsionMode { Exact, BarnesHut };
 
 class Physics {
 public:
@@ -8,5 +14,68 @@ public:
     float drag = 4.0f;
     float maxSpeed = 10000.0f;
 
+    RepulsionMode repulsionMode = RepulsionMode::BarnesHut;
+    float theta = 0.7f; // Barnes-Hut opening angle (0 = exact, larger = faster/coarser)
+
+    // Worker count for the force passes (0 = one per hardware thread).
+    // Results are deterministic for a fixed count.
+    int threads = 0;
+
+    // A node slower than sleepSpeed for sleepSteps steps in a row falls
+    // asleep: it still repels, but is no longer moved. It wakes when an
+    // edge neighbour, or any node within wakeRadius, moves faster than
+    // wakeSpeed, and when wake() is called for it.
+    float sleepSpeed = 0.1f;
+    int sleepSteps = 60;
+    float wakeSpeed = 0.25f;
+    float wakeRadius = 3.0f;
+    // Below this total kinetic energy the layout counts as settled
+    float settleEnergy = 0.01f;
+
     void update(Graph& graph, float dt);
+    // One step over bare simulation state, for callers that keep their own
+    // copy of it (see PhysicsThread)
+    void step(NodeArrays& sim, const std::vector<Edge>& edges, float dt);
+    // For nodes disturbed from outside: moved, added, or given an edge
+    void wake(NodeArrays& sim, int idx);
+
+    // Of the nodes that moved in the last step
+    float kineticEnergy() const { return energy; }
+    int awakeCount() const { return awake; }
+    // Nothing left worth stepping until something is changed or woken
+    bool settled() const { return energy < settleEnergy; }
+
+    // Octree over the node positions as of the end of the last step.
+    // Slots added since are not in it; slots deleted since still may be.
+    const Octree& spatialIndex() const { return octree; }
+
+private:
+    struct Accumulator {
+        std::vector<float> x, y, z;
+    };
+    struct TaskStats {
+        float energy = 0.0f;
+        int awake = 0, asleep = 0;
+        std::vector<int> fast; // Awake nodes faster than wakeSpeed
+    };
+
+    Octree octree;
+    std::unique_ptr<ThreadPool> pool;
+    std::vector<Accumulator> accumulators; // Per-task velocity deltas
+    std::vector<TaskStats> taskStats;
+    std::vector<uint16_t> calmSteps; // Steps each node has been below sleepSpeed
+    std::vector<uint8_t> fastNodes;  // By slot, set from taskStats after integrate
+    std::vector<int> wakeStack;
+    float energy = std::numeric_limits<float>::max();
+    int awake = 0;
+
+    ThreadPool& workers();
+    int taskCount(size_t items) const;
+    void forEachTask(int tasks, const std::function<void(int)>& fn);
+    void applyRepulsionExact(NodeArrays& sim, float dt, int tasks);
+    void applyRepulsionBarnesHut(NodeArrays& sim, float dt, int tasks);
+    void applySprings(NodeArrays& sim, const std::vector<Edge>& edges, float dt, int tasks);
+    void integrate(NodeArrays& sim, float dt, int tasks);
+    void reduceAccumulators(NodeArrays& sim, int tasks);
+    void wakeNeighbours(NodeArrays& sim, const std::vector<Edge>& edges, int tasks);
 };
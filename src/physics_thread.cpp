@@ -0,0 +1,266 @@
+#include "physics_thread.h"
+#include <algorithm>
+
+PhysicsThread::~PhysicsThread() {
+    stop();
+}
+
+void PhysicsThread::start() {
+    if (thread.joinable()) return;
+    stopping = false;
+    reset();
+    thread = std::thread(&PhysicsThread::run, this);
+}
+
+void PhysicsThread::stop() {
+    if (!thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+void PhysicsThread::touch(int idx, uint8_t fields) {
+    if (idx < 0) return;
+    if (idx >= (int)dirtyFields.size()) dirtyFields.resize(idx + 1, 0);
+    if (!dirtyFields[idx]) dirtySlots.push_back(idx);
+    dirtyFields[idx] |= fields;
+}
+
+void PhysicsThread::Commands::clear() {
+    sequence = 0;
+    reset = false;
+    sim.clear();
+    replaceEdges = false;
+    edges.clear();
+    nodes.clear();
+}
+
+void PhysicsThread::Commands::append(Commands& later) {
+    if (later.reset) {
+        // Supersedes everything sent before it
+        std::swap(*this, later);
+        return;
+    }
+    sequence = later.sequence;
+    if (later.replaceEdges) {
+        replaceEdges = true;
+        std::swap(edges, later.edges);
+    } else {
+        edges.insert(edges.end(), later.edges.begin(), later.edges.end());
+    }
+    nodes.insert(nodes.end(), later.nodes.begin(), later.nodes.end());
+}
+
+void PhysicsThread::sync(Graph& graph) {
+    send(graph);
+    receive(graph);
+}
+
+void PhysicsThread::send(const Graph& graph) {
+    size_t n = graph.sim.count();
+    if (resetPending) {
+        resetPending = false;
+        outgoing.reset = true;
+        outgoing.sim = graph.sim;
+        outgoing.replaceEdges = true;
+        outgoing.edges = graph.edges;
+        outgoing.nodes.clear();
+        edgesSent = graph.edges.size();
+        sentEdgeLayout = graph.edgeLayout();
+        for (int idx : dirtySlots) dirtyFields[idx] = 0;
+        dirtySlots.clear();
+    }
+
+    // Edges are appended until one is removed, which reorders the array
+    if (graph.edgeLayout() != sentEdgeLayout || graph.edges.size() < edgesSent) {
+        outgoing.replaceEdges = true;
+        outgoing.edges = graph.edges;
+    } else {
+        outgoing.edges.insert(outgoing.edges.end(), graph.edges.begin() + edgesSent, graph.edges.end());
+    }
+    edgesSent = graph.edges.size();
+    sentEdgeLayout = graph.edgeLayout();
+
+    positionSentAt.resize(n, 0);
+    for (int idx : dirtySlots) {
+        uint8_t fields = dirtyFields[idx];
+        dirtyFields[idx] = 0;
+        if (idx >= (int)n) continue; // Gone with a clear()
+        const NodeArrays& s = graph.sim;
+        outgoing.nodes.push_back({idx, fields, glm::vec3(s.x[idx], s.y[idx], s.z[idx]),
+                                  glm::vec3(s.vx[idx], s.vy[idx], s.vz[idx]), s.size[idx], s.flags[idx]});
+    }
+    dirtySlots.clear();
+    if (outgoing.empty()) return;
+
+    outgoing.sequence = ++sequence;
+    if (outgoing.reset) resetSequence = sequence;
+    // Only sizes changing leaves the drawn positions as they are
+    bool onlySizes = !outgoing.reset && !outgoing.replaceEdges && outgoing.edges.empty();
+    for (const NodeCommand& c : outgoing.nodes) {
+        if (c.fields & FieldPosition) positionSentAt[c.slot] = sequence;
+        if (c.fields & FieldSize) sizesSent = true;
+        if (c.fields & ~FieldSize) onlySizes = false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (queued.empty()) {
+            std::swap(queued, outgoing);
+        } else {
+            queued.append(outgoing);
+        }
+    }
+    wake.notify_one(); // In case the thread is paused
+    outgoing.clear();
+    if (!onlySizes) displayCurrent = false;
+}
+
+void PhysicsThread::receive(Graph& graph) {
+    bool fresh = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (readyFresh) {
+            std::swap(previous, current);
+            std::swap(current, ready);
+            readyFresh = false;
+            fresh = true;
+        }
+    }
+    Clock::time_point now = Clock::now();
+    if (fresh) displayCurrent = false;
+    if (displayCurrent) {
+        // Paused and no position changed since the last frame, but the
+        // tree's padding still has to follow sizes written since
+        if (sizesSent) refitIndex(graph);
+        sizesSent = false;
+        return;
+    }
+    if (fresh && current.valid) {
+        float elapsed = std::chrono::duration<float>(now - rateStart).count();
+        if (elapsed >= 1.0f || current.step < rateStartStep) {
+            measuredRate = current.step >= rateStartStep ? (current.step - rateStartStep) / elapsed : 0.0f;
+            rateStart = now;
+            rateStartStep = current.step;
+        }
+    }
+
+    // Draw one step behind, moving from the previous step to the current
+    // one over the time the current one took
+    NodeArrays& s = graph.sim;
+    if (previous.valid && current.valid && previous.sequence >= resetSequence) {
+        float span = std::chrono::duration<float>(current.time - previous.time).count();
+        float t = span > 0.0f ? std::chrono::duration<float>(now - current.time).count() / span : 1.0f;
+        t = std::clamp(t, 0.0f, 1.0f);
+        // Once the thread paused there is nothing left to move towards
+        if (t == 1.0f && current.settled) displayCurrent = true;
+        size_t count = std::min({previous.x.size(), current.x.size(), s.count()});
+        for (size_t i = 0; i < count; i++) {
+            // Positions the main thread wrote win until both steps include them
+            if (positionSentAt[i] > previous.sequence || (s.flags[i] & NodeDeleted)) continue;
+            s.x[i] = previous.x[i] + (current.x[i] - previous.x[i]) * t;
+            s.y[i] = previous.y[i] + (current.y[i] - previous.y[i]) * t;
+            s.z[i] = previous.z[i] + (current.z[i] - previous.z[i]) * t;
+        }
+    }
+
+    refitIndex(graph);
+    sizesSent = false;
+}
+
+void PhysicsThread::refitIndex(const Graph& graph) {
+    // The published tree, fitted to what is drawn
+    const NodeArrays& s = graph.sim;
+    current.index.refit(s.x.data(), s.y.data(), s.z.data(), s.size.data(), s.count(), s.flags.data(), NodeDeleted);
+}
+
+void PhysicsThread::apply(Commands& commands) {
+    if (commands.reset) {
+        std::swap(sim, commands.sim);
+        for (int i = 0; i < (int)sim.count(); i++) physics.wake(sim, i);
+    }
+    for (const NodeCommand& c : commands.nodes) {
+        if (c.slot >= (int)sim.count()) sim.resize(c.slot + 1);
+        if (c.fields & FieldPosition) {
+            sim.x[c.slot] = c.pos.x;
+            sim.y[c.slot] = c.pos.y;
+            sim.z[c.slot] = c.pos.z;
+        }
+        if (c.fields & FieldVelocity) {
+            sim.vx[c.slot] = c.vel.x;
+            sim.vy[c.slot] = c.vel.y;
+            sim.vz[c.slot] = c.vel.z;
+        }
+        if (c.fields & FieldSize) sim.size[c.slot] = c.size;
+        if (c.fields & FieldFlags) sim.flags[c.slot] = c.flags;
+        physics.wake(sim, c.slot);
+    }
+
+    // New edges wake both ends; the ends of removed edges are found by
+    // looking for edges to deleted nodes in the list being replaced
+    if (commands.replaceEdges) {
+        std::swap(edges, commands.edges);
+        for (const Edge& e : commands.edges) {
+            if (e.from >= (int)sim.count() || e.to >= (int)sim.count()) continue;
+            if (sim.flags[e.from] & NodeDeleted) physics.wake(sim, e.to);
+            if (sim.flags[e.to] & NodeDeleted) physics.wake(sim, e.from);
+        }
+    } else {
+        for (const Edge& e : commands.edges) {
+            physics.wake(sim, e.from);
+            physics.wake(sim, e.to);
+        }
+        edges.insert(edges.end(), commands.edges.begin(), commands.edges.end());
+    }
+    if (commands.sequence) appliedSequence = commands.sequence;
+    commands.clear();
+}
+
+void PhysicsThread::publish() {
+    back.x = sim.x;
+    back.y = sim.y;
+    back.z = sim.z;
+    back.index = physics.spatialIndex();
+    back.sequence = appliedSequence;
+    back.step = steps;
+    back.awake = physics.awakeCount();
+    back.settled = physics.settled();
+    back.time = Clock::now();
+    back.valid = true;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::swap(back, ready);
+    readyFresh = true;
+}
+
+void PhysicsThread::run() {
+    auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / stepRate));
+    Clock::time_point next = Clock::now();
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (physics.settled()) {
+                // Nothing moves until a command changes something
+                wake.wait(lock, [this] { return stopping || !queued.empty(); });
+                next = std::max(next, Clock::now());
+            } else {
+                wake.wait_until(lock, next, [this] { return stopping; });
+            }
+            if (stopping) return;
+            std::swap(incoming, queued);
+        }
+        apply(incoming);
+        physics.step(sim, edges, 1.0f / stepRate);
+        steps++;
+        publish();
+
+        // A step that overran starts the next one right away; the lost time
+        // is dropped rather than caught up, so the layout slows down instead
+        next += interval;
+        Clock::time_point now = Clock::now();
+        if (next < now) next = now;
+    }
+}
@@ -0,0 +1,142 @@
+#pragma once
+#include "graph.h"
+#include "octree.h"
+#include "physics.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs Physics on its own thread at a fixed timestep, so a slow layout
+// lowers the step rate instead of the frame rate and dt never spikes.
+//
+// The thread simulates a private copy of the node arrays and edges. The
+// Graph stays the main thread's, and changes to it reach the copy as
+// commands: structural ones through the GraphObserver interface, direct
+// writes to Graph::sim through touch(). sync() sends them once per frame.
+// In the other direction each step publishes the new positions, and sync()
+// writes Graph::sim positions interpolated between the two newest steps.
+// Velocities in Graph::sim are only an input; they are not read back.
+//
+// Once Physics reports the layout settled the thread stops stepping and
+// waits for the next command, and sync() stops touching the graph.
+class PhysicsThread : public GraphObserver {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Parts of Graph::sim written directly, for touch()
+    enum Fields : uint8_t {
+        FieldPosition = 1 << 0,
+        FieldVelocity = 1 << 1,
+        FieldSize = 1 << 2,
+        FieldFlags = 1 << 3,
+        FieldAll = 0xF,
+    };
+
+    // Settings are read by the thread: change them before start() only
+    Physics physics;
+    float stepRate = 60.0f; // Steps per second; each advances 1 / stepRate
+
+    ~PhysicsThread();
+
+    // Starts stepping; the first sync() sends the whole graph
+    void start();
+    void stop();
+
+    // Sends the graph wholesale, for changes made with the observer detached
+    void reset() { resetPending = true; }
+    // Sends fields of a slot as they are in the graph at the next sync()
+    void touch(int idx, uint8_t fields);
+    // Once per frame: sends what changed, then moves the graph's positions
+    // to the latest published steps
+    void sync(Graph& graph);
+
+    // Octree over the positions sync() last wrote
+    const Octree& spatialIndex() const { return current.index; }
+    // Measured over the last second
+    float stepsPerSecond() const { return measuredRate; }
+    // As of the newest published step
+    int awakeCount() const { return current.awake; }
+    // Paused until the graph changes
+    bool settled() const { return current.settled; }
+
+    void nodeAdded(const Graph& graph, int idx) override { touch(idx, FieldAll); }
+    void nodeDeleted(const Graph& graph, int idx) override { touch(idx, FieldAll); }
+    void pinChanged(const Graph& graph, int idx) override { touch(idx, FieldFlags); }
+    void cleared(const Graph& graph) override { reset(); }
+
+private:
+    struct NodeCommand {
+        int slot;
+        uint8_t fields;
+        glm::vec3 pos, vel;
+        float size;
+        uint8_t flags;
+    };
+    // Everything sent by one sync(), applied by the thread before its next step
+    struct Commands {
+        uint64_t sequence = 0;
+        bool reset = false;         // sim and edges replace the thread's copy
+        NodeArrays sim;
+        bool replaceEdges = false;  // edges replace the thread's list, else extend it
+        std::vector<Edge> edges;        // Applied after nodes
+        std::vector<NodeCommand> nodes; // Applied after reset, in order
+
+        bool empty() const { return !reset && !replaceEdges && edges.empty() && nodes.empty(); }
+        void clear();
+        void append(Commands& later);
+    };
+    struct Snapshot {
+        std::vector<float> x, y, z;
+        Octree index;
+        uint64_t sequence = 0; // Last command batch applied before the step
+        uint64_t step = 0;
+        int awake = 0;
+        bool settled = false;
+        Clock::time_point time;
+        bool valid = false;
+    };
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    // Shared, guarded by mutex
+    Commands queued;
+    Snapshot ready;
+    bool readyFresh = false;
+
+    // Thread only
+    NodeArrays sim;
+    std::vector<Edge> edges;
+    Commands incoming;
+    Snapshot back;
+    uint64_t appliedSequence = 0;
+    uint64_t steps = 0;
+
+    // Main thread only
+    Commands outgoing;
+    uint64_t sequence = 0;
+    uint64_t resetSequence = 0;
+    bool resetPending = false;
+    std::vector<uint8_t> dirtyFields;
+    std::vector<int> dirtySlots;
+    std::vector<uint64_t> positionSentAt; // Batch that last carried each slot's position
+    size_t edgesSent = 0;
+    uint32_t sentEdgeLayout = ~0u;
+    Snapshot previous, current;
+    bool displayCurrent = false; // Graph positions match a settled current step
+    bool sizesSent = false;      // Since the index was last refitted
+    Clock::time_point rateStart;
+    uint64_t rateStartStep = 0;
+    float measuredRate = 0.0f;
+
+    void run();
+    void apply(Commands& commands);
+    void publish();
+    void send(const Graph& graph);
+    void receive(Graph& graph);
+    void refitIndex(const Graph& graph);
+};
@@ -1,4 +1,5 @@
 #include "renderer.h"
+#include "frustum.h"
 #include "star_png.h"
 #include "font_ttf.h"
 #include <SDL2/SDL_image.h>
@@ -6,6 +7,17 @@
 #include <iostream>
 #include <cmath>
 #include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+// Labels considered for placement per frame, biggest nodes first
+static const size_t maxLabelCandidates = 4096;
+
+// Octree cells are only collapsed into a single impostor beyond the
+// distance where the edge alpha falloff in edgeVertSrc reaches its floor,
+// 0.9 / (1 + 0.01 d^2) = 0.05, and only when they span fewer pixels than this
+static const float lodDistance = 41.2f;
+static const float lodPixels = 4.0f;
 
 // Billboard vertex shader with instancing
 static const char* nodeVertSrc = R"(
@@ -63,6 +75,48 @@ void main() {
 }
 )";
 
+// Edges expanded on the GPU: one instance per edge, two vertices each.
+// Endpoints are looked up in the node buffer, so only node data is
+// uploaded per frame.
+static const char* edgeVertSrc = R"(
+#version 330 core
+layout(location = 0) in ivec2 aEnds; // from, to node slots
+layout(location = 1) in float aFadeIn;
+out vec4 vColor;
+uniform samplerBuffer uNodes;        // xyz = position, w = size, negated when collapsed
+uniform mat4 uVP;
+uniform vec3 uCameraPos;
+void main() {
+    vec4 a = texelFetch(uNodes, aEnds.x);
+    vec4 b = texelFetch(uNodes, aEnds.y);
+    // The line grows out from its source while fading in
+    vec3 end = mix(a.xyz, b.xyz, aFadeIn);
+
+    // Both vertices reach the same verdict, so a culled line is clipped whole:
+    // lines inside a collapsed cluster, and lines with both ends outside one
+    // side of the frustum
+    vec4 clipA = uVP * vec4(a.xyz, 1.0);
+    vec4 clipB = uVP * vec4(end, 1.0);
+    vec3 lowA = clipA.xyz + clipA.w, lowB = clipB.xyz + clipB.w;   // Negative past the left, bottom, near planes
+    vec3 highA = clipA.w - clipA.xyz, highB = clipB.w - clipB.xyz; // Negative past the right, top, far planes
+    bool outside = any(lessThan(max(lowA, lowB), vec3(0.0))) || any(lessThan(max(highA, highB), vec3(0.0)));
+    if ((a.w < 0.0 && b.w < 0.0) || outside) {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        vColor = vec4(0.0);
+        return;
+    }
+
+    float distFromCam = length((a.xyz + b.xyz) * 0.5 - uCameraPos);
+    float combinedSize = (abs(a.w) + abs(b.w)) * 0.5;
+    float alpha = clamp(0.9 / (1.0 + distFromCam * distFromCam * 0.01), 0.05, 0.9);
+    alpha *= (0.3 + combinedSize * 0.4) * aFadeIn;
+    float brightness = 0.15 + combinedSize * 0.25;
+
+    gl_Position = gl_VertexID == 0 ? clipA : clipB;
+    vColor = vec4(brightness, brightness, brightness + 0.15, alpha);
+}
+)";
+
 static const char* uiVertSrc = R"(
 #version 330 core
 layout(location = 0) in vec2 aPos;
@@ -114,24 +168,27 @@ void main() {
 
 static const char* textVertSrc = R"(
 #version 330 core
-layout(location = 0) in vec4 aVertex; // xy = pos, zw = uv
+layout(location = 0) in vec4 aVertex; // xy = pos, zw = uv in texels
+layout(location = 1) in vec4 aColor;
 out vec2 vUV;
+out vec4 vColor;
 uniform mat4 uProj;
+uniform sampler2D uTexture;
 void main() {
     gl_Position = uProj * vec4(aVertex.xy, 0.0, 1.0);
-    vUV = aVertex.zw;
+    vUV = aVertex.zw / vec2(textureSize(uTexture, 0));
+    vColor = aColor;
 }
 )";
 
 static const char* textFragSrc = R"(
 #version 330 core
 in vec2 vUV;
+in vec4 vColor;
 out vec4 fragColor;
 uniform sampler2D uTexture;
-uniform vec3 uColor;
 void main() {
-    vec4 tex = texture(uTexture, vUV);
-    fragColor = vec4(uColor, tex.a);
+    fragColor = vec4(vColor.rgb, vColor.a * texture(uTexture, vUV).r);
 }
 )";
 
@@ -221,7 +278,6 @@ void Renderer::initBillboard() {
 
     glGenVertexArrays(1, &billboardVAO);
     glGenBuffers(1, &billboardVBO);
-    glGenBuffers(1, &instanceVBO);
 
     glBindVertexArray(billboardVAO);
 
@@ -233,50 +289,123 @@ void Renderer::initBillboard() {
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
     glEnableVertexAttribArray(1);
 
-    // Instance data: vec3 pos, float size, vec3 color = 7 floats per instance
-    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-    glBufferData(GL_ARRAY_BUFFER, 100000 * 7 * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
-
-    // aWorldPos (location 2)
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(2);
-    glVertexAttribDivisor(2, 1);
-
-    // aSize (location 3)
-    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(3);
-    glVertexAttribDivisor(3, 1);
+    // Instance data: vec3 pos, float size, vec3 color = 7 floats per instance,
+    // streamed each frame; see instanceAttributes
+    nodeStream.init(16384 * 7 * sizeof(float));
+    for (GLuint loc = 2; loc <= 4; loc++) {
+        glEnableVertexAttribArray(loc);
+        glVertexAttribDivisor(loc, 1);
+    }
+}
 
-    // aColor (location 4)
-    glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void*)(4 * sizeof(float)));
-    glEnableVertexAttribArray(4);
-    glVertexAttribDivisor(4, 1);
+// Points the instance attributes of billboardVAO (bound) at offset in the bound buffer
+static void instanceAttributes(size_t offset) {
+    const GLsizei stride = 7 * sizeof(float);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, (void*)offset);                       // aWorldPos
+    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, stride, (void*)(offset + 3 * sizeof(float))); // aSize
+    glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, stride, (void*)(offset + 4 * sizeof(float))); // aColor
 }
 
 void Renderer::initLineMesh() {
     // Batched lines: pos (3) + color (4) = 7 floats per vertex, 2 vertices per line
     glGenVertexArrays(1, &batchedLineVAO);
-    glGenBuffers(1, &batchedLineVBO);
     glBindVertexArray(batchedLineVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, batchedLineVBO);
-    glBufferData(GL_ARRAY_BUFFER, 500000 * 14 * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
+    overlayStream.init(4096 * 14 * sizeof(float));
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+}
 
-    // Position
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void*)0);
+void Renderer::initEdgeMesh() {
+    // Graph::edges is uploaded as is; the shader reads the endpoints and fadeIn
+    static_assert(sizeof(Edge) == 16, "edge instance stride");
+    glGenVertexArrays(1, &edgeVAO);
+    glGenBuffers(1, &edgeVBO);
+    glBindVertexArray(edgeVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, edgeVBO);
+    edgeCapacity = 65536;
+    glBufferData(GL_ARRAY_BUFFER, edgeCapacity * sizeof(Edge), nullptr, GL_DYNAMIC_DRAW);
+    glVertexAttribIPointer(0, 2, GL_INT, sizeof(Edge), (void*)offsetof(Edge, from));
     glEnableVertexAttribArray(0);
-    // Color
-    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void*)(3 * sizeof(float)));
+    glVertexAttribDivisor(0, 1);
+    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, sizeof(Edge), (void*)offsetof(Edge, fadeIn));
     glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+
+    // Node position and size by slot, read through a buffer texture
+    glGenBuffers(1, &nodeBuffer);
+    glGenTextures(1, &nodeTexture);
+}
+
+// Brings edgeVBO up to date with graph.edges. Appended edges and those
+// still fading in are uploaded; anything else only after edges were
+// removed or reordered. Edges fade in at the same rate in the order they
+// were added, so the ones still fading are a suffix of the array.
+void Renderer::syncEdges(const Graph& graph) {
+    const auto& edges = graph.edges;
+    size_t first = std::min(firstFadingEdge, edgesUploaded);
+    if (graph.edgeLayout() != uploadedEdgeLayout || edges.size() < edgesUploaded) {
+        first = 0;
+        uploadedEdgeLayout = graph.edgeLayout();
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, edgeVBO);
+    if (edges.size() > edgeCapacity) {
+        edgeCapacity = std::max(edges.size(), edgeCapacity * 2);
+        glBufferData(GL_ARRAY_BUFFER, edgeCapacity * sizeof(Edge), nullptr, GL_DYNAMIC_DRAW);
+        first = 0;
+    }
+    if (first < edges.size()) {
+        glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(Edge), (edges.size() - first) * sizeof(Edge), &edges[first]);
+    }
+    edgesUploaded = edges.size();
+
+    // Edges uploaded fully faded in are done; the rest go again next frame
+    while (first < edges.size() && edges[first].fadeIn >= 1.0f) first++;
+    firstFadingEdge = first;
+}
+
+// Writes x, y, z and size of every slot into the node buffer texture
+void Renderer::uploadNodes(const Graph& graph) {
+    size_t bytes = std::max<size_t>(graph.nodes.size(), 1) * 4 * sizeof(float);
+    glBindBuffer(GL_TEXTURE_BUFFER, nodeBuffer);
+    // Orphaned each frame so the upload never waits for the previous draw
+    glBufferData(GL_TEXTURE_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+    float* out = (float*)glMapBufferRange(GL_TEXTURE_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (out) {
+        // Collapsed nodes are flagged by a negative size for the edge shader
+        const NodeArrays& sim = graph.sim;
+        for (size_t i = 0; i < graph.nodes.size(); i++) {
+            out[i * 4 + 0] = sim.x[i];
+            out[i * 4 + 1] = sim.y[i];
+            out[i * 4 + 2] = sim.z[i];
+            out[i * 4 + 3] = nodeVisibility[i] == NodeCollapsed ? -sim.size[i] : sim.size[i];
+        }
+        glUnmapBuffer(GL_TEXTURE_BUFFER);
+    }
+    glBindTexture(GL_TEXTURE_BUFFER, nodeTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, nodeBuffer);
+}
+
+// Points the attributes of batchedLineVAO (bound) at offset in the bound buffer
+static void lineAttributes(size_t offset) {
+    const GLsizei stride = 7 * sizeof(float);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offset);                       // Position
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, (void*)(offset + 3 * sizeof(float))); // Color
 }
 
 void Renderer::initTextQuad() {
+    // Glyph quads: pos + uv (4) and color (4) per vertex, grown by flushText as needed
+    const GLsizei stride = GlyphAtlas::vertexFloats * sizeof(float);
     glGenVertexArrays(1, &textVAO);
     glGenBuffers(1, &textVBO);
     glBindVertexArray(textVAO);
     glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-    glBufferData(GL_ARRAY_BUFFER, 6 * 4 * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), nullptr);
+    textBufferSize = 4096 * 6 * stride;
+    glBufferData(GL_ARRAY_BUFFER, textBufferSize, nullptr, GL_DYNAMIC_DRAW);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride, nullptr);
     glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, (void*)(4 * sizeof(float)));
+    glEnableVertexAttribArray(1);
 }
 
 void Renderer::initQuad() {
@@ -293,33 +422,120 @@ void Renderer::initQuad() {
     glEnableVertexAttribArray(0);
 }
 
-Renderer::CachedText Renderer::getTextTexture(const std::string& text) {
-    if (text.empty()) return {0, 0, 0};
-    if (!font) return {0, 0, 0};
+void Renderer::queueText(std::string_view text, float x, float y, const glm::vec4& color) {
+    if (!text.empty() && font) glyphs.appendText(textVertices, text, x, y, color);
+}
 
-    SDL_Color white = {255, 255, 255, 255};
-    SDL_Surface* surface = TTF_RenderUTF8_Blended(font, text.c_str(), white);
-    if (!surface) return {0, 0, 0};
+// Draws everything queued since the last flush in one call
+void Renderer::flushText(const glm::mat4& ortho) {
+    if (textVertices.empty()) return;
 
-    SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ABGR8888, 0);
-    SDL_FreeSurface(surface);
-    if (!converted) return {0, 0, 0};
+    glUseProgram(textShader);
+    glUniformMatrix4fv(glGetUniformLocation(textShader, "uProj"), 1, GL_FALSE, glm::value_ptr(ortho));
+    glBindTexture(GL_TEXTURE_2D, glyphs.texture());
+    glBindVertexArray(textVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, textVBO);
 
-    GLuint tex;
-    glGenTextures(1, &tex);
-    glBindTexture(GL_TEXTURE_2D, tex);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, converted->w, converted->h, 0,
-                 GL_RGBA, GL_UNSIGNED_BYTE, converted->pixels);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // Orphan the old storage each frame so the driver never waits on the previous draw
+    size_t bytes = textVertices.size() * sizeof(float);
+    if (bytes > textBufferSize) textBufferSize = std::max(bytes, textBufferSize * 2);
+    glBufferData(GL_ARRAY_BUFFER, textBufferSize, nullptr, GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, textVertices.data());
+    glDrawArrays(GL_TRIANGLES, 0, textVertices.size() / GlyphAtlas::vertexFloats);
 
-    CachedText result = {tex, converted->w, converted->h};
-    SDL_FreeSurface(converted);
-    return result;
+    textVertices.clear();
+}
+
+// Fills nodeVisibility, visibleNodes and impostors for this frame. Cells of
+// the spatial index outside the frustum are skipped whole; small, distant
+// ones become a single impostor point. Slots the index doesn't cover are
+// tested one by one.
+void Renderer::cullNodes(const Graph& graph, const Octree* index, const Camera& camera, int selectedNode,
+                         const std::vector<int>* marked) {
+    Frustum frustum(viewProj);
+    nodeVisibility.assign(graph.nodes.size(), NodeCulled);
+    visibleNodes.clear();
+    impostors.clear();
+
+    auto visit = [&](int idx, bool test) {
+        if (!graph.alive(idx) || graph.nodes[idx].fadeIn < 0.01f) return;
+        if (test && !frustum.sphere(graph.position(idx), graph.size(idx) * 0.15f)) return;
+        nodeVisibility[idx] = NodeVisible;
+        visibleNodes.push_back(idx);
+    };
+
+    int covered = 0;
+    if (index && !index->empty()) {
+        const auto& cells = index->cells();
+        const auto& order = index->indices();
+        covered = std::min<int>(index->pointCount(), graph.nodes.size());
+        float pixelsPerUnit = proj[1][1] * screenHeight * 0.5f; // At distance 1
+
+        cullStack.clear();
+        cullStack.push_back({0, false});
+        while (!cullStack.empty()) {
+            auto [c, inside] = cullStack.back();
+            cullStack.pop_back();
+            const Octree::Cell& cell = cells[c];
+            if (cell.count == 0) continue;
+
+            if (!inside) {
+                // Bounds hold node centers; pad them by the largest billboard radius
+                float pad = cell.maxSize * 0.15f;
+                int side = frustum.classify(cell.lo - pad, cell.hi + pad);
+                if (side < 0) continue;
+                inside = side > 0;
+            }
+
+            if (cell.count > 1) {
+                float dist = glm::length(cell.centroid - camera.position);
+                float extent = glm::length(cell.hi - cell.lo);
+                if (dist > lodDistance && extent * pixelsPerUnit < lodPixels * dist) {
+                    // Same billboard area as the nodes it stands in for
+                    impostors.push_back({cell.centroid, 0.15f * std::sqrt(cell.sizeSum)});
+                    for (int k = cell.begin; k < cell.end; k++) {
+                        int idx = order[k];
+                        if (idx < covered && graph.alive(idx)) nodeVisibility[idx] = NodeCollapsed;
+                    }
+                    continue;
+                }
+            }
+
+            if (cell.firstChild < 0) {
+                for (int k = cell.begin; k < cell.end; k++) {
+                    if (order[k] < covered) visit(order[k], !inside);
+                }
+            } else {
+                for (int k = cell.firstChild; k < cell.firstChild + cell.childCount; k++) {
+                    cullStack.push_back({k, inside});
+                }
+            }
+        }
+    }
+    if (covered > 0) {
+        for (int idx : index->excluded()) {
+            if (idx < covered) visit(idx, true);
+        }
+    }
+    for (int idx = covered; idx < (int)graph.nodes.size(); idx++) visit(idx, true);
+
+    // Selected nodes always stand on their own
+    auto standAlone = [&](int idx) {
+        if (idx >= 0 && idx < (int)graph.nodes.size() && nodeVisibility[idx] == NodeCollapsed) visit(idx, true);
+    };
+    standAlone(selectedNode);
+    nodeMarked.assign(graph.nodes.size(), 0);
+    if (marked) {
+        for (int idx : *marked) {
+            if (idx < 0 || idx >= (int)graph.nodes.size()) continue;
+            nodeMarked[idx] = 1;
+            standAlone(idx);
+        }
+    }
 }
 
 glm::vec3 Renderer::worldToScreen(const glm::vec3& worldPos) {
-    glm::vec4 clip = proj * view * glm::vec4(worldPos, 1.0f);
+    glm::vec4 clip = viewProj * glm::vec4(worldPos, 1.0f);
     if (clip.w <= 0) return glm::vec3(-1000, -1000, -1); // Behind camera
 
     glm::vec3 ndc = glm::vec3(clip) / clip.w;
@@ -341,6 +557,7 @@ bool Renderer::init() {
 
     nodeShader = compileShader(nodeVertSrc, nodeFragSrc);
     lineShader = compileShader(lineVertSrc, lineFragSrc);
+    edgeShader = compileShader(edgeVertSrc, lineFragSrc);
     uiShader = compileShader(uiVertSrc, uiFragSrc);
     textShader = compileShader(textVertSrc, textFragSrc);
     roundedShader = compileShader(roundedVertSrc, roundedFragSrc);
@@ -352,9 +569,11 @@ bool Renderer::init() {
     if (!loadFont()) {
         std::cerr << "Warning: failed to load font\n";
     }
+    glyphs.init(font);
 
     initBillboard();
     initLineMesh();
+    initEdgeMesh();
     initTextQuad();
     initQuad();
 
@@ -362,20 +581,26 @@ bool Renderer::init() {
 }
 
 void Renderer::shutdown() {
+    glyphs.shutdown();
     if (font) TTF_CloseFont(font);
     TTF_Quit();
     IMG_Quit();
 
     glDeleteProgram(nodeShader);
     glDeleteProgram(lineShader);
+    glDeleteProgram(edgeShader);
     glDeleteProgram(uiShader);
     glDeleteProgram(textShader);
     glDeleteProgram(roundedShader);
     glDeleteVertexArrays(1, &billboardVAO);
     glDeleteBuffers(1, &billboardVBO);
-    glDeleteBuffers(1, &instanceVBO);
+    nodeStream.shutdown();
     glDeleteVertexArrays(1, &batchedLineVAO);
-    glDeleteBuffers(1, &batchedLineVBO);
+    overlayStream.shutdown();
+    glDeleteVertexArrays(1, &edgeVAO);
+    glDeleteBuffers(1, &edgeVBO);
+    glDeleteBuffers(1, &nodeBuffer);
+    glDeleteTextures(1, &nodeTexture);
     glDeleteVertexArrays(1, &textVAO);
     glDeleteBuffers(1, &textVBO);
     glDeleteVertexArrays(1, &quadVAO);
@@ -392,12 +617,13 @@ void Renderer::begin(const Camera& camera, int screenW, int screenH) {
 
     view = camera.getViewMatrix();
     proj = camera.getProjectionMatrix((float)screenW / screenH);
+    viewProj = proj * view;
 }
 
 // Hash a domain string to a vibrant HSL color
-static glm::vec3 domainToColor(const std::string& url) {
+static glm::vec3 domainToColor(std::string_view url) {
     // Extract domain from URL
-    std::string domain = url;
+    std::string domain(url);
     size_t protoEnd = domain.find("://");
     if (protoEnd != std::string::npos) {
         domain = domain.substr(protoEnd + 3);
@@ -479,85 +705,48 @@ static glm::vec3 domainToColor(const std::string& url) {
 }
 
 void Renderer::renderGraph(const Graph& graph, int selectedNode, const Camera& camera, int screenW, int screenH, float dt,
-                           bool showNodes, bool showLinks, bool showLabels, bool domainColors) {
-    // Build and render batched line data
-    lineVertices.clear();
-    if (showLinks) {
-        lineVertices.reserve(graph.edges.size() * 14); // 7 floats per vertex, 2 vertices per line
-
-        for (const auto& edge : graph.edges) {
-            if (edge.from < 0 || edge.from >= (int)graph.nodes.size()) continue;
-            if (edge.to < 0 || edge.to >= (int)graph.nodes.size()) continue;
-            const auto& nodeA = graph.nodes[edge.from];
-            const auto& nodeB = graph.nodes[edge.to];
-
-            glm::vec3 startPos = nodeA.position;
-            glm::vec3 endPos = glm::mix(nodeA.position, nodeB.position, edge.fadeIn);
-
-            glm::vec3 edgeMid = (nodeA.position + nodeB.position) * 0.5f;
-            float distFromCam = glm::length(edgeMid - camera.position);
-            float combinedSize = (nodeA.size + nodeB.size) * 0.5f;
-
-            float alpha = 0.9f / (1.0f + distFromCam * distFromCam * 0.01f);
-            alpha = std::max(0.05f, std::min(alpha, 0.9f));
-            alpha *= (0.3f + combinedSize * 0.4f);
-            alpha *= edge.fadeIn;
-
-            float brightness = 0.15f + combinedSize * 0.25f;
-
-            // Start vertex
-            lineVertices.push_back(startPos.x);
-            lineVertices.push_back(startPos.y);
-            lineVertices.push_back(startPos.z);
-            lineVertices.push_back(brightness);
-            lineVertices.push_back(brightness);
-            lineVertices.push_back(brightness + 0.15f);
-            lineVertices.push_back(alpha);
-
-            // End vertex
-            lineVertices.push_back(endPos.x);
-            lineVertices.push_back(endPos.y);
-            lineVertices.push_back(endPos.z);
-            lineVertices.push_back(brightness);
-            lineVertices.push_back(brightness);
-            lineVertices.push_back(brightness + 0.15f);
-            lineVertices.push_back(alpha);
-        }
+                           bool showNodes, bool showLinks, bool showLabels, bool domainColors, const Octree* spatialIndex,
+                           const std::vector<int>* marked) {
+    cullNodes(graph, spatialIndex, camera, selectedNode, marked);
 
-        // Render all edges in one draw call
-        glDisable(GL_DEPTH_TEST);
-        glUseProgram(lineShader);
-        glUniformMatrix4fv(glGetUniformLocation(lineShader, "uVP"), 1, GL_FALSE, glm::value_ptr(proj * view));
+    // Render all edges in one draw call, expanded on the GPU
+    if (showLinks && !graph.edges.empty()) {
+        syncEdges(graph);
+        uploadNodes(graph);
 
-        glBindVertexArray(batchedLineVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, batchedLineVBO);
-        if (!lineVertices.empty()) {
-            glBufferSubData(GL_ARRAY_BUFFER, 0, lineVertices.size() * sizeof(float), lineVertices.data());
-        }
+        glDisable(GL_DEPTH_TEST);
+        glUseProgram(edgeShader);
+        glUniformMatrix4fv(glGetUniformLocation(edgeShader, "uVP"), 1, GL_FALSE, glm::value_ptr(viewProj));
+        glUniform3fv(glGetUniformLocation(edgeShader, "uCameraPos"), 1, glm::value_ptr(camera.position));
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_BUFFER, nodeTexture);
+        glUniform1i(glGetUniformLocation(edgeShader, "uNodes"), 0);
 
+        glBindVertexArray(edgeVAO);
         glEnable(GL_LINE_SMOOTH);
         glEnable(GL_BLEND);
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         glLineWidth(2.0f);
-        glDrawArrays(GL_LINES, 0, lineVertices.size() / 7);
+        glDrawArraysInstanced(GL_LINES, 0, 2, graph.edges.size());
         glLineWidth(1.0f);
         glEnable(GL_DEPTH_TEST);
     }
 
     // Build and render node instance data
-    if (showNodes) {
-        nodeInstances.clear();
-        nodeInstances.reserve(graph.nodes.size() * 7);
+    if (showNodes && (!visibleNodes.empty() || !impostors.empty())) {
+        glBindVertexArray(billboardVAO);
+        float* out = (float*)nodeStream.map((visibleNodes.size() + impostors.size()) * 7 * sizeof(float));
+        size_t instanceCount = 0;
 
-        for (size_t i = 0; i < graph.nodes.size(); i++) {
+        for (size_t k = 0; out && k < visibleNodes.size(); k++) {
+            int i = visibleNodes[k];
             const auto& node = graph.nodes[i];
-            if (node.fadeIn < 0.01f) continue;
 
-            float visualSize = node.size * 0.15f * node.fadeIn;
+            float visualSize = graph.size(i) * 0.15f * node.fadeIn;
 
             glm::vec3 color;
             if (domainColors && node.status == NodeStatus::Success) {
-                color = domainToColor(node.url);
+                color = domainToColor(graph.url(i));
             } else {
                 switch (node.status) {
                     case NodeStatus::Pending: color = glm::vec3(0.4f, 0.6f, 1.0f); break;
@@ -566,19 +755,35 @@ void Renderer::renderGraph(const Graph& graph, int selectedNode, const Camera& c
                 }
             }
 
-            if ((int)i == selectedNode) {
+            if (i == selectedNode) {
                 color = glm::vec3(1.0f, 1.0f, 0.4f);
+            } else if (nodeMarked[i]) {
+                color = glm::vec3(1.0f, 0.6f, 0.2f);
             }
             color *= node.fadeIn;
 
-            nodeInstances.push_back(node.position.x);
-            nodeInstances.push_back(node.position.y);
-            nodeInstances.push_back(node.position.z);
-            nodeInstances.push_back(visualSize);
-            nodeInstances.push_back(color.r);
-            nodeInstances.push_back(color.g);
-            nodeInstances.push_back(color.b);
+            float* v = out + instanceCount * 7;
+            v[0] = graph.sim.x[i];
+            v[1] = graph.sim.y[i];
+            v[2] = graph.sim.z[i];
+            v[3] = visualSize;
+            v[4] = color.r;
+            v[5] = color.g;
+            v[6] = color.b;
+            instanceCount++;
         }
+        for (size_t k = 0; out && k < impostors.size(); k++) {
+            float* v = out + instanceCount * 7;
+            v[0] = impostors[k].pos.x;
+            v[1] = impostors[k].pos.y;
+            v[2] = impostors[k].pos.z;
+            v[3] = impostors[k].size;
+            v[4] = 0.75f;
+            v[5] = 0.8f;
+            v[6] = 0.95f;
+            instanceCount++;
+        }
+        instanceAttributes(nodeStream.commit());
 
         // Render all nodes in one instanced draw call
         glUseProgram(nodeShader);
@@ -589,15 +794,10 @@ void Renderer::renderGraph(const Graph& graph, int selectedNode, const Camera& c
         glBindTexture(GL_TEXTURE_2D, starTexture);
         glUniform1i(glGetUniformLocation(nodeShader, "uTexture"), 0);
 
-        glBindVertexArray(billboardVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-        if (!nodeInstances.empty()) {
-            glBufferSubData(GL_ARRAY_BUFFER, 0, nodeInstances.size() * sizeof(float), nodeInstances.data());
-        }
-
         glDepthMask(GL_FALSE);
-        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, nodeInstances.size() / 7);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, instanceCount);
         glDepthMask(GL_TRUE);
+        nodeStream.fence();
     }
 
     // Render pin indicators (blue circles around pinned nodes)
@@ -605,14 +805,14 @@ void Renderer::renderGraph(const Graph& graph, int selectedNode, const Camera& c
         std::vector<float> pinCircleVerts;
         const int segments = 24;
 
-        for (size_t i = 0; i < graph.nodes.size(); i++) {
+        for (int i : visibleNodes) {
             const auto& node = graph.nodes[i];
-            if (!node.pinned || node.fadeIn < 0.01f) continue;
+            if (!graph.pinned(i)) continue;
 
-            glm::vec3 screenPos = worldToScreen(node.position);
+            glm::vec3 screenPos = worldToScreen(graph.position(i));
             if (screenPos.z < -1 || screenPos.z > 1) continue;
 
-            float radius = 12.0f + node.size * 8.0f;
+            float radius = 12.0f + graph.size(i) * 8.0f;
             float alpha = node.fadeIn * 0.8f;
 
             for (int s = 0; s < segments; s++) {
@@ -650,14 +850,17 @@ void Renderer::renderGraph(const Graph& graph, int selectedNode, const Camera& c
             glUniformMatrix4fv(glGetUniformLocation(lineShader, "uVP"), 1, GL_FALSE, glm::value_ptr(ortho));
 
             glBindVertexArray(batchedLineVAO);
-            glBindBuffer(GL_ARRAY_BUFFER, batchedLineVBO);
-            glBufferSubData(GL_ARRAY_BUFFER, 0, pinCircleVerts.size() * sizeof(float), pinCircleVerts.data());
+            size_t bytes = pinCircleVerts.size() * sizeof(float);
+            void* out = overlayStream.map(bytes);
+            if (out) memcpy(out, pinCircleVerts.data(), bytes);
+            lineAttributes(overlayStream.commit());
 
             glEnable(GL_LINE_SMOOTH);
             glLineWidth(2.0f);
-            glDrawArrays(GL_LINES, 0, pinCircleVerts.size() / 7);
+            glDrawArrays(GL_LINES, 0, out ? pinCircleVerts.size() / 7 : 0);
             glLineWidth(1.0f);
             glEnable(GL_DEPTH_TEST);
+            overlayStream.fence();
         }
     }
 
@@ -665,95 +868,67 @@ void Renderer::renderGraph(const Graph& graph, int selectedNode, const Camera& c
     glDisable(GL_DEPTH_TEST);
 
     glm::mat4 ortho = glm::ortho(0.0f, (float)screenW, (float)screenH, 0.0f);
-    glUseProgram(textShader);
-    glUniformMatrix4fv(glGetUniformLocation(textShader, "uProj"), 1, GL_FALSE, glm::value_ptr(ortho));
-    glBindVertexArray(textVAO);
-
-    // Sort nodes by size (biggest first) for label priority
-    std::vector<size_t> sortedIndices(graph.nodes.size());
-    for (size_t i = 0; i < graph.nodes.size(); i++) sortedIndices[i] = i;
-    std::sort(sortedIndices.begin(), sortedIndices.end(), [&](size_t a, size_t b) {
-        if ((int)a == selectedNode) return true;
-        if ((int)b == selectedNode) return false;
-        return graph.nodes[a].size > graph.nodes[b].size;
-    });
+    float lineHeight = glyphs.lineHeight();
 
     // Reset visibility flags for all labels
     for (auto& [idx, state] : labelStates) {
         state.visible = false;
     }
 
-    // Track occupied screen regions for occlusion
-    std::vector<std::tuple<float, float, float, float>> occupiedRects;
+    // First pass: collect nodes near enough to be labelled whose label would
+    // land on screen. Skip if labels are hidden (but still process fade-out below)
+    labelCandidates.clear();
+    for (size_t k = 0; showLabels && k < visibleNodes.size(); k++) {
+        int idx = visibleNodes[k];
 
-    // First pass: determine which labels should be visible and their target positions
-    // Skip if labels are hidden (but still process fade-out below)
-    for (size_t idx : sortedIndices) {
-        if (!showLabels) break;
-        const auto& node = graph.nodes[idx];
-        if (node.fadeIn < 0.01f) continue;
+        glm::vec3 nodePos = graph.position(idx);
+        glm::vec3 toNode = nodePos - camera.position;
+        float nodeSize = graph.size(idx);
+        float maxDist = 5.0f + nodeSize * nodeSize * 25.0f;
+        if (glm::dot(toNode, toNode) > maxDist * maxDist) continue;
 
-        glm::vec3 screenPos = worldToScreen(node.position);
+        glm::vec3 screenPos = worldToScreen(nodePos);
         if (screenPos.z < -1 || screenPos.z > 1) continue;
 
-        float dist = glm::length(node.position - camera.position);
-        float maxDist = 5.0f + node.size * node.size * 25.0f;
-        if (dist > maxDist) continue;
-
-        // Prepare label text
-        std::string label = node.url;
-        size_t protoEnd = label.find("://");
-        if (protoEnd != std::string::npos) {
-            label = label.substr(protoEnd + 3);
-        }
-        if (!label.empty() && label.back() == '/') {
-            label.pop_back();
-        }
-        if ((int)idx != selectedNode && label.length() > 40) {
-            label = label.substr(0, 37) + "...";
-        } else if (label.length() > 100) {
-            label = label.substr(0, 97) + "...";
-        }
-        if (node.status == NodeStatus::Error && node.httpCode != 0) {
-            label += " - " + std::to_string(node.httpCode);
-        }
-        if (label.empty()) continue;
-
-        // Estimate text size for occlusion check
-        int estW = 0, estH = 0;
-        if (font) TTF_SizeUTF8(font, label.c_str(), &estW, &estH);
-        if (estW == 0) continue;
-
-        float targetX = screenPos.x - estW / 2.0f;
-        float targetY = screenPos.y + 15.0f;
-
-        // Check overlap
-        bool overlaps = false;
-        if ((int)idx != selectedNode) {
-            for (const auto& rect : occupiedRects) {
-                float rx = std::get<0>(rect), ry = std::get<1>(rect);
-                float rw = std::get<2>(rect), rh = std::get<3>(rect);
-                if (targetX < rx + rw && targetX + estW > rx && targetY < ry + rh && targetY + estH > ry) {
-                    overlaps = true;
-                    break;
-                }
-            }
-        }
-
-        if (!overlaps) {
-            occupiedRects.push_back({targetX, targetY, (float)estW, (float)estH});
-
-            // Update or create label state
-            auto& state = labelStates[(int)idx];
-            state.visible = true;
-            state.targetX = targetX;
-            state.targetY = targetY;
+        const LabelText& label = labelText(graph, idx, (int)idx == selectedNode);
+        if (label.width == 0) continue;
+        float x = screenPos.x - label.width / 2.0f;
+        float y = screenPos.y + 15.0f;
+        if (x + label.width < 0 || x > screenW || y + lineHeight < 0 || y > screenH) continue;
+        labelCandidates.push_back({(int)idx, graph.sim.size[idx], x, y, label.width});
+    }
 
-            // Initialize position if this is a new label
-            if (state.opacity < 0.01f) {
-                state.x = targetX;
-                state.y = targetY;
-            }
+    // Biggest first, the selected node ahead of everything. Far more labels
+    // than fit on screen are never placed, so only the front is ordered.
+    auto labelOrder = [&](const LabelCandidate& a, const LabelCandidate& b) {
+        if (a.idx == selectedNode) return b.idx != selectedNode;
+        if (b.idx == selectedNode) return false;
+        return a.size > b.size;
+    };
+    size_t placeable = std::min(labelCandidates.size(), maxLabelCandidates);
+    std::partial_sort(labelCandidates.begin(), labelCandidates.begin() + placeable, labelCandidates.end(), labelOrder);
+
+    // Place labels that don't overlap one already placed
+    labelGrid.reset(screenW, screenH);
+    for (size_t c = 0; c < placeable; c++) {
+        const LabelCandidate& cand = labelCandidates[c];
+        glm::vec4 rect(cand.x, cand.y, cand.width, lineHeight);
+        if (cand.idx != selectedNode && labelGrid.overlaps(rect)) continue;
+        labelGrid.insert(rect);
+
+        // Update or create label state
+        auto& state = labelStates[cand.idx];
+        uint32_t generation = graph.nodes[cand.idx].generation;
+        if (state.generation != generation) state = LabelState(); // Slot was reused
+        state.generation = generation;
+        state.visible = true;
+        state.targetX = cand.x;
+        state.targetY = cand.y;
+
+        // Initialize position if this is a new label
+        if (state.opacity < 0.01f) {
+            state.x = cand.x;
+            state.y = cand.y;
         }
     }
 
@@ -773,24 +948,6 @@ void Renderer::renderGraph(const Graph& graph, int selectedNode, const Camera& c
             state.opacity = targetOpacity;
         }
 
-        // Update position - always track the node
-        // For fading out labels, recalculate target from node position
-        if (!state.visible && idx >= 0 && idx < (int)graph.nodes.size()) {
-            glm::vec3 screenPos = worldToScreen(graph.nodes[idx].position);
-            int estW = 0, estH = 0;
-            std::string label = graph.nodes[idx].url;
-            size_t pe = label.find("://");
-            if (pe != std::string::npos) label = label.substr(pe + 3);
-            if (!label.empty() && label.back() == '/') label.pop_back();
-            if (font) TTF_SizeUTF8(font, label.c_str(), &estW, &estH);
-            state.targetX = screenPos.x - estW / 2.0f;
-            state.targetY = screenPos.y + 15.0f;
-        }
-
-        // Snap to target (no camera lag) - smooth fade is enough
-        state.x = state.targetX;
-        state.y = state.targetY;
-
         // Skip rendering if fully faded out
         if (state.opacity < 0.01f) {
             if (!state.visible) toRemove.push_back(idx);
@@ -798,58 +955,31 @@ void Renderer::renderGraph(const Graph& graph, int selectedNode, const Camera& c
         }
 
         // Node might have been deleted
-        if (idx < 0 || idx >= (int)graph.nodes.size()) {
+        bool nodeAlive = graph.alive(idx) && graph.nodes[idx].generation == state.generation;
+        if (!nodeAlive) {
             toRemove.push_back(idx);
             continue;
         }
 
-        const auto& node = graph.nodes[idx];
+        const LabelText& label = labelText(graph, idx, idx == selectedNode);
+        if (label.width == 0) continue;
 
-        // Prepare label text
-        std::string label = node.url;
-        size_t protoEnd = label.find("://");
-        if (protoEnd != std::string::npos) {
-            label = label.substr(protoEnd + 3);
-        }
-        if (!label.empty() && label.back() == '/') {
-            label.pop_back();
-        }
-        if (idx != selectedNode && label.length() > 40) {
-            label = label.substr(0, 37) + "...";
-        } else if (label.length() > 100) {
-            label = label.substr(0, 97) + "...";
-        }
-        if (node.status == NodeStatus::Error && node.httpCode != 0) {
-            label += " - " + std::to_string(node.httpCode);
+        // Fading labels keep tracking their node
+        if (!state.visible) {
+            glm::vec3 screenPos = worldToScreen(graph.position(idx));
+            state.targetX = screenPos.x - label.width / 2.0f;
+            state.targetY = screenPos.y + 15.0f;
         }
-        if (label.empty()) continue;
-
-        auto cached = getTextTexture(label);
-        if (!cached.tex) continue;
 
-        float x = state.x;
-        float y = state.y;
-
-        glBindTexture(GL_TEXTURE_2D, cached.tex);
-
-        float verts[] = {
-            x,            y,            0.0f, 0.0f,
-            x + cached.w, y,            1.0f, 0.0f,
-            x + cached.w, y + cached.h, 1.0f, 1.0f,
-            x,            y,            0.0f, 0.0f,
-            x + cached.w, y + cached.h, 1.0f, 1.0f,
-            x,            y + cached.h, 0.0f, 1.0f,
-        };
-
-        glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(verts), verts);
+        // Snap to target (no camera lag) - smooth fade is enough
+        state.x = state.targetX;
+        state.y = state.targetY;
 
         glm::vec3 textColor = (idx == selectedNode) ? glm::vec3(1.0f, 1.0f, 0.4f) : glm::vec3(0.7f, 0.7f, 0.8f);
-        textColor *= state.opacity * node.fadeIn;
-        glUniform3fv(glGetUniformLocation(textShader, "uColor"), 1, glm::value_ptr(textColor));
-
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        textColor *= state.opacity * graph.nodes[idx].fadeIn;
+        queueText(label.text, state.x, state.y, glm::vec4(textColor, 1.0f));
     }
+    flushText(ortho);
 
     // Clean up labels for deleted nodes
     for (int idx : toRemove) {
@@ -859,6 +989,82 @@ void Renderer::renderGraph(const Graph& graph, int selectedNode, const Camera& c
     glEnable(GL_DEPTH_TEST);
 }
 
+const Renderer::LabelText& Renderer::labelText(const Graph& graph, int idx, bool selected) {
+    if ((size_t)idx >= labelTexts.size()) labelTexts.resize(graph.nodes.size());
+    const Node& node = graph.nodes[idx];
+    LabelText& label = labelTexts[idx];
+    if (label.valid && label.generation == node.generation && label.selected == selected &&
+        label.status == node.status && label.httpCode == node.httpCode) {
+        return label;
+    }
+
+    std::string_view url = graph.url(idx);
+    size_t protoEnd = url.find("://");
+    if (protoEnd != std::string_view::npos) url.remove_prefix(protoEnd + 3);
+    if (!url.empty() && url.back() == '/') url.remove_suffix(1);
+
+    // The selected node gets a longer label
+    size_t maxLength = selected ? 100 : 40;
+    label.text.assign(url.substr(0, url.size() > maxLength ? maxLength - 3 : url.size()));
+    if (url.size() > maxLength) label.text += "...";
+    if (node.status == NodeStatus::Error && node.httpCode != 0) {
+        label.text += " - " + std::to_string(node.httpCode);
+    }
+
+    label.valid = true;
+    label.generation = node.generation;
+    label.selected = selected;
+    label.status = node.status;
+    label.httpCode = node.httpCode;
+    label.width = label.text.empty() ? 0 : glyphs.measure(label.text);
+    return label;
+}
+
+void Renderer::LabelGrid::reset(int screenW, int screenH) {
+    int newCols = std::max(1, (int)std::ceil(screenW / cellSize));
+    int newRows = std::max(1, (int)std::ceil(screenH / cellSize));
+    if (newCols != cols || newRows != rows) {
+        cols = newCols;
+        rows = newRows;
+        cells.assign((size_t)cols * rows, {});
+    }
+    for (auto& cell : cells) cell.clear(); // Keeps each cell's capacity for the next frame
+    rects.clear();
+}
+
+// Rect indices are listed in every cell the rect touches; rects reaching
+// past the screen edge are clamped to the border cells
+void Renderer::LabelGrid::cellRange(const glm::vec4& r, int& x0, int& y0, int& x1, int& y1) const {
+    x0 = std::clamp((int)std::floor(r.x / cellSize), 0, cols - 1);
+    y0 = std::clamp((int)std::floor(r.y / cellSize), 0, rows - 1);
+    x1 = std::clamp((int)std::floor((r.x + r.z) / cellSize), 0, cols - 1);
+    y1 = std::clamp((int)std::floor((r.y + r.w) / cellSize), 0, rows - 1);
+}
+
+bool Renderer::LabelGrid::overlaps(const glm::vec4& r) const {
+    int x0, y0, x1, y1;
+    cellRange(r, x0, y0, x1, y1);
+    for (int cy = y0; cy <= y1; cy++) {
+        for (int cx = x0; cx <= x1; cx++) {
+            for (int i : cells[(size_t)cy * cols + cx]) {
+                const glm::vec4& o = rects[i];
+                if (r.x < o.x + o.z && r.x + r.z > o.x && r.y < o.y + o.w && r.y + r.w > o.y) return true;
+            }
+        }
+    }
+    return false;
+}
+
+void Renderer::LabelGrid::insert(const glm::vec4& r) {
+    int x0, y0, x1, y1;
+    cellRange(r, x0, y0, x1, y1);
+    int id = rects.size();
+    rects.push_back(r);
+    for (int cy = y0; cy <= y1; cy++) {
+        for (int cx = x0; cx <= x1; cx++) cells[(size_t)cy * cols + cx].push_back(id);
+    }
+}
+
 void Renderer::renderCrosshair(int screenW, int screenH) {
     glDisable(GL_DEPTH_TEST);
     glUseProgram(uiShader);
@@ -908,33 +1114,8 @@ void Renderer::renderAddressBar(const std::string& text, int screenW, int screen
     glDrawArrays(GL_TRIANGLES, 0, 6);
 
     // Render actual text
-    if (!text.empty() && font) {
-        glUseProgram(textShader);
-        glUniformMatrix4fv(glGetUniformLocation(textShader, "uProj"), 1, GL_FALSE, glm::value_ptr(ortho));
-
-        auto cached = getTextTexture(text);
-        if (cached.tex) {
-            glBindTexture(GL_TEXTURE_2D, cached.tex);
-            glBindVertexArray(textVAO);
-
-            float x = barX + 12.0f;
-            float y = barY + (barH - cached.h) / 2.0f;
-
-            float verts[] = {
-                x,            y,            0.0f, 0.0f,
-                x + cached.w, y,            1.0f, 0.0f,
-                x + cached.w, y + cached.h, 1.0f, 1.0f,
-                x,            y,            0.0f, 0.0f,
-                x + cached.w, y + cached.h, 1.0f, 1.0f,
-                x,            y + cached.h, 0.0f, 1.0f,
-            };
-
-            glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-            glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(verts), verts);
-            glUniform3f(glGetUniformLocation(textShader, "uColor"), 1.0f, 1.0f, 1.0f);
-            glDrawArrays(GL_TRIANGLES, 0, 6);
-        }
-    }
+    queueText(text, barX + 12.0f, barY + (barH - glyphs.lineHeight()) / 2.0f, glm::vec4(1.0f));
+    flushText(ortho);
 
     // Cursor
     glUseProgram(uiShader);
@@ -943,9 +1124,7 @@ void Renderer::renderAddressBar(const std::string& text, int screenW, int screen
 
     float cursorX = barX + 12.0f;
     if (!text.empty() && font) {
-        int w, h;
-        TTF_SizeUTF8(font, text.c_str(), &w, &h);
-        cursorX += w + 2;
+        cursorX += glyphs.measure(text) + 2;
     }
 
     glUniform3f(glGetUniformLocation(uiShader, "uColor"), 1.0f, 1.0f, 1.0f);
@@ -960,41 +1139,35 @@ void Renderer::renderText2D(const std::string& text, float x, float y, glm::vec3
     // Utility for future use
 }
 
-void Renderer::renderStats(int screenW, int screenH, int nodeCount, int edgeCount, int pendingCount) {
+void Renderer::renderStats(int screenW, int screenH, int nodeCount, int edgeCount, int pendingCount,
+                           int inFlightCount, const std::vector<std::string>& detailLines) {
     glDisable(GL_DEPTH_TEST);
 
     glm::mat4 ortho = glm::ortho(0.0f, (float)screenW, (float)screenH, 0.0f);
-    glUseProgram(textShader);
-    glUniformMatrix4fv(glGetUniformLocation(textShader, "uProj"), 1, GL_FALSE, glm::value_ptr(ortho));
-    glBindVertexArray(textVAO);
 
     std::string stats = std::to_string(nodeCount) + " nodes | " +
                         std::to_string(edgeCount) + " edges";
     if (pendingCount > 0) {
         stats += " | " + std::to_string(pendingCount) + " pending";
     }
+    if (inFlightCount > 0) {
+        stats += " | " + std::to_string(inFlightCount) + " fetching";
+    }
 
-    auto cached = getTextTexture(stats);
-    if (cached.tex) {
-        float x = 10.0f;
-        float y = 10.0f;
-
-        glBindTexture(GL_TEXTURE_2D, cached.tex);
-
-        float verts[] = {
-            x,            y,            0.0f, 0.0f,
-            x + cached.w, y,            1.0f, 0.0f,
-            x + cached.w, y + cached.h, 1.0f, 1.0f,
-            x,            y,            0.0f, 0.0f,
-            x + cached.w, y + cached.h, 1.0f, 1.0f,
-            x,            y + cached.h, 0.0f, 1.0f,
-        };
-
-        glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(verts), verts);
-        glUniform3f(glGetUniformLocation(textShader, "uColor"), 0.5f, 0.5f, 0.6f);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+    // Summary line first, then one dimmer line per detail entry
+    std::vector<std::string> lines;
+    lines.push_back(stats);
+    lines.insert(lines.end(), detailLines.begin(), detailLines.end());
+
+    float x = 10.0f;
+    float y = 10.0f;
+    for (size_t i = 0; i < lines.size(); i++) {
+        if (lines[i].empty()) continue;
+        float shade = i == 0 ? 1.0f : 0.75f;
+        queueText(lines[i], x, y, glm::vec4(0.5f * shade, 0.5f * shade, 0.6f * shade, 1.0f));
+        y += glyphs.lineHeight() + 2.0f;
     }
+    flushText(ortho);
 
     glEnable(GL_DEPTH_TEST);
 }
@@ -1028,10 +1201,6 @@ void Renderer::renderVisibilityMenu(int screenW, int screenH, int selection, boo
     const char* labels[] = {"1. Nodes", "2. Links", "3. Labels", "4. Domain Colors", "5. Stats"};
     bool values[] = {showNodes, showLinks, showLabels, domainColors, showStats};
 
-    glUseProgram(textShader);
-    glUniformMatrix4fv(glGetUniformLocation(textShader, "uProj"), 1, GL_FALSE, glm::value_ptr(ortho));
-    glBindVertexArray(textVAO);
-
     for (int i = 0; i < 5; i++) {
         float itemY = menuY + padding + i * itemH;
 
@@ -1044,39 +1213,18 @@ void Renderer::renderVisibilityMenu(int screenW, int screenH, int selection, boo
             glUniform2f(glGetUniformLocation(roundedShader, "uSize"), menuW - 12, itemH - 4);
             glUniform1f(glGetUniformLocation(roundedShader, "uRadius"), 4.0f);
             glDrawArrays(GL_TRIANGLES, 0, 6);
-            glUseProgram(textShader);
-            glUniformMatrix4fv(glGetUniformLocation(textShader, "uProj"), 1, GL_FALSE, glm::value_ptr(ortho));
-            glBindVertexArray(textVAO);
         }
 
         // Checkbox
         std::string checkbox = values[i] ? "[x] " : "[ ] ";
         std::string text = checkbox + labels[i];
 
-        auto cached = getTextTexture(text);
-        if (!cached.tex) continue;
-
         float x = menuX + padding;
-        float y = itemY + (itemH - cached.h) / 2.0f;
-
-        glBindTexture(GL_TEXTURE_2D, cached.tex);
-
-        float verts[] = {
-            x,            y,            0.0f, 0.0f,
-            x + cached.w, y,            1.0f, 0.0f,
-            x + cached.w, y + cached.h, 1.0f, 1.0f,
-            x,            y,            0.0f, 0.0f,
-            x + cached.w, y + cached.h, 1.0f, 1.0f,
-            x,            y + cached.h, 0.0f, 1.0f,
-        };
-
-        glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(verts), verts);
-
+        float y = itemY + (itemH - glyphs.lineHeight()) / 2.0f;
         glm::vec3 color = (i == selection) ? glm::vec3(1.0f, 1.0f, 0.4f) : glm::vec3(0.8f, 0.8f, 0.9f);
-        glUniform3fv(glGetUniformLocation(textShader, "uColor"), 1, glm::value_ptr(color));
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        queueText(text, x, y, glm::vec4(color, 1.0f));
     }
+    flushText(ortho);
 
     glEnable(GL_DEPTH_TEST);
 }
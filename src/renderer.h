@@ -1,6 +1,9 @@
 #pragma once
 #include "graph.h"
 #include "camera.h"
+#include "octree.h"
+#include "glyph_atlas.h"
+#include "stream_buffer.h"
 #include <GL/glew.h>
 #include <SDL2/SDL_ttf.h>
 #include <string>
@@ -14,26 +17,49 @@ public:
 
     void begin(const Camera& camera, int screenW, int screenH);
     void renderGraph(const Graph& graph, int selectedNode, const Camera& camera, int screenW, int screenH, float dt,
-                     bool showNodes = true, bool showLinks = true, bool showLabels = true, bool domainColors = false);
+                     bool showNodes = true, bool showLinks = true, bool showLabels = true, bool domainColors = false,
+                     const Octree* spatialIndex = nullptr, const std::vector<int>* marked = nullptr);
     void renderCrosshair(int screenW, int screenH);
     void renderText2D(const std::string& text, float x, float y, glm::vec3 color);
     void renderAddressBar(const std::string& text, int screenW, int screenH, bool active);
     void renderVisibilityMenu(int screenW, int screenH, int selection, bool showNodes, bool showLinks, bool showLabels, bool domainColors, bool showStats);
-    void renderStats(int screenW, int screenH, int nodeCount, int edgeCount, int pendingCount);
+    void renderStats(int screenW, int screenH, int nodeCount, int edgeCount, int pendingCount,
+                     int inFlightCount = 0, const std::vector<std::string>& detailLines = {});
 
 private:
-    GLuint nodeShader = 0, lineShader = 0, textShader = 0, uiShader = 0, roundedShader = 0;
-    GLuint billboardVAO = 0, billboardVBO = 0, instanceVBO = 0;
-    GLuint batchedLineVAO = 0, batchedLineVBO = 0;
+    GLuint nodeShader = 0, lineShader = 0, edgeShader = 0, textShader = 0, uiShader = 0, roundedShader = 0;
+    GLuint billboardVAO = 0, billboardVBO = 0;
+    GLuint batchedLineVAO = 0;
     GLuint textVAO = 0, textVBO = 0;
     GLuint quadVAO = 0, quadVBO = 0;
     GLuint starTexture = 0;
 
-    std::vector<float> lineVertices;
-    std::vector<float> nodeInstances;
+    // Per-frame vertex data: node instances and screen-space overlay lines
+    StreamBuffer nodeStream, overlayStream;
+
+    // Culling results by slot, see cullNodes
+    enum NodeVisibility : uint8_t { NodeCulled, NodeVisible, NodeCollapsed };
+    std::vector<uint8_t> nodeVisibility;
+    std::vector<uint8_t> nodeMarked; // Part of the multi-selection
+    std::vector<int> visibleNodes;
+    struct Impostor {
+        glm::vec3 pos;
+        float size;
+    };
+    std::vector<Impostor> impostors; // Stand-ins for collapsed octree cells
+    std::vector<std::pair<int, bool>> cullStack; // Cell, known to be inside the frustum
+
+    // Graph::edges mirrored on the GPU, see syncEdges
+    GLuint edgeVAO = 0, edgeVBO = 0;
+    size_t edgeCapacity = 0, edgesUploaded = 0, firstFadingEdge = 0;
+    uint32_t uploadedEdgeLayout = ~0u;
+    // Node positions and sizes for the edge shader, by slot
+    GLuint nodeBuffer = 0, nodeTexture = 0;
 
     TTF_Font* font = nullptr;
-    struct CachedText { GLuint tex; int w, h; };
+    GlyphAtlas glyphs;
+    std::vector<float> textVertices; // Queued text quads, drawn by flushText
+    size_t textBufferSize = 0;       // Bytes allocated for textVBO
 
     // Per-label state for smooth transitions
     struct LabelState {
@@ -41,10 +67,45 @@ private:
         float targetX = 0, targetY = 0; // Target position
         float opacity = 0;            // Current opacity (0 = hidden, 1 = visible)
         bool visible = false;         // Should be visible this frame
+        uint32_t generation = 0;      // Node generation the state belongs to
     };
     std::unordered_map<int, LabelState> labelStates;
 
-    glm::mat4 view, proj;
+    // Label text and width per node slot, rebuilt when what it shows changes
+    struct LabelText {
+        bool valid = false;
+        uint32_t generation = 0;
+        bool selected = false;
+        NodeStatus status = NodeStatus::Pending;
+        int httpCode = 0;
+        std::string text;
+        float width = 0;
+    };
+    std::vector<LabelText> labelTexts;
+
+    // A node whose label could be placed this frame, at its target position
+    struct LabelCandidate {
+        int idx;
+        float size;
+        float x, y, width;
+    };
+    std::vector<LabelCandidate> labelCandidates;
+
+    // Uniform screen-space grid of placed label rects for occlusion tests
+    struct LabelGrid {
+        static constexpr float cellSize = 64.0f;
+        int cols = 0, rows = 0;
+        std::vector<std::vector<int>> cells; // Indices into rects, per cell
+        std::vector<glm::vec4> rects;        // x, y, w, h
+
+        void reset(int screenW, int screenH);
+        bool overlaps(const glm::vec4& r) const;
+        void insert(const glm::vec4& r);
+        void cellRange(const glm::vec4& r, int& x0, int& y0, int& x1, int& y1) const;
+    };
+    LabelGrid labelGrid;
+
+    glm::mat4 view, proj, viewProj;
     int screenWidth = 0, screenHeight = 0;
 
     GLuint compileShader(const char* vert, const char* frag);
@@ -52,8 +113,15 @@ private:
     bool loadFont();
     void initBillboard();
     void initLineMesh();
+    void initEdgeMesh();
+    void cullNodes(const Graph& graph, const Octree* index, const Camera& camera, int selectedNode,
+                   const std::vector<int>* marked);
+    void syncEdges(const Graph& graph);
+    void uploadNodes(const Graph& graph);
     void initTextQuad();
     void initQuad();
-    CachedText getTextTexture(const std::string& text);
+    void queueText(std::string_view text, float x, float y, const glm::vec4& color);
+    void flushText(const glm::mat4& ortho);
+    const LabelText& labelText(const Graph& graph, int idx, bool selected);
     glm::vec3 worldToScreen(const glm::vec3& worldPos);
 };
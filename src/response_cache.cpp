@@ -0,0 +1,141 @@
+#include "response_cache.h"
+#include "url.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+static const char* cacheMagic = "constellarix-cache 1";
+
+static uint64_t fnv1a(const std::string& s) {
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+bool ResponseCache::open(const std::string& dir) {
+    std::string path = dir;
+    if (path.empty()) {
+        if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+            path = std::string(xdg) + "/constellarix";
+        } else if (const char* home = std::getenv("HOME"); home && *home) {
+            path = std::string(home) + "/.cache/constellarix";
+        } else {
+            path = ".constellarix-cache";
+        }
+    }
+
+    std::error_code ec;
+    fs::create_directories(path, ec);
+    if (ec) {
+        std::cerr << "Cache disabled, cannot create " << path << ": " << ec.message() << "\n";
+        root.clear();
+        return false;
+    }
+    root = path;
+    return true;
+}
+
+std::string ResponseCache::normalizeKey(const std::string& url) {
+    std::string canonical = canonicalUrl(url);
+    return canonical.empty() ? url : canonical;
+}
+
+std::string ResponseCache::pathFor(const std::string& key) const {
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx", (unsigned long long)fnv1a(key));
+    return root + "/" + std::string(name, 2) + "/" + name;
+}
+
+bool ResponseCache::lookup(const std::string& url, CacheEntry& entry) const {
+    if (!isOpen()) return false;
+    std::string key = normalizeKey(url);
+    std::ifstream in(pathFor(key));
+    if (!in) return false;
+
+    std::string line;
+    if (!std::getline(in, line) || line != cacheMagic) return false;
+
+    CacheEntry e;
+    size_t linkCount = 0;
+    while (std::getline(in, line)) {
+        size_t space = line.find(' ');
+        std::string field = line.substr(0, space);
+        std::string value = space == std::string::npos ? "" : line.substr(space + 1);
+        if (field == "url") e.url = value;
+        else if (field == "status") e.statusCode = std::atoi(value.c_str());
+        else if (field == "fetched") e.fetchedAt = (time_t)std::atoll(value.c_str());
+        else if (field == "max-age") e.maxAge = std::atol(value.c_str());
+        else if (field == "etag") e.etag = value;
+        else if (field == "last-modified") e.lastModified = value;
+        else if (field == "links") {
+            linkCount = std::strtoul(value.c_str(), nullptr, 10);
+            break;
+        }
+    }
+
+    // Hash collisions and truncated files both read as misses
+    if (normalizeKey(e.url) != key) return false;
+    e.links.reserve(linkCount);
+    while (e.links.size() < linkCount && std::getline(in, line)) e.links.push_back(line);
+    if (e.links.size() != linkCount) return false;
+
+    entry = std::move(e);
+    return true;
+}
+
+bool ResponseCache::store(const CacheEntry& entry) {
+    if (!isOpen()) return false;
+    std::string path = pathFor(normalizeKey(entry.url));
+    std::string tmp = path + ".tmp";
+
+    std::error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        if (!out) return false;
+        out << cacheMagic << "\n"
+            << "url " << entry.url << "\n"
+            << "status " << entry.statusCode << "\n"
+            << "fetched " << (long long)entry.fetchedAt << "\n"
+            << "max-age " << entry.maxAge << "\n";
+        if (!entry.etag.empty()) out << "etag " << entry.etag << "\n";
+        if (!entry.lastModified.empty()) out << "last-modified " << entry.lastModified << "\n";
+        // One link per line, so links that span lines cannot be stored
+        auto storable = [](const std::string& link) { return link.find_first_of("\r\n") == std::string::npos; };
+        out << "links " << std::count_if(entry.links.begin(), entry.links.end(), storable) << "\n";
+        for (const auto& link : entry.links) {
+            if (storable(link)) out << link << "\n";
+        }
+        if (!out) return false;
+    }
+
+    // Rename so readers never see a half-written entry
+    fs::rename(tmp, path, ec);
+    return !ec;
+}
+
+std::vector<std::string> ResponseCache::validators(const CacheEntry& entry) {
+    std::vector<std::string> headers;
+    if (!entry.etag.empty()) headers.push_back("If-None-Match: " + entry.etag);
+    if (!entry.lastModified.empty()) headers.push_back("If-Modified-Since: " + entry.lastModified);
+    return headers;
+}
+
+long ResponseCache::maxAgeFor(const std::string& cacheControl) const {
+    std::string cc = cacheControl;
+    std::transform(cc.begin(), cc.end(), cc.begin(), ::tolower);
+    if (cc.find("no-store") != std::string::npos) return -1;
+    if (cc.find("no-cache") != std::string::npos) return 0;
+    size_t pos = cc.find("max-age=");
+    if (pos != std::string::npos) return std::max(0L, std::atol(cc.c_str() + pos + 8));
+    return defaultMaxAge;
+}
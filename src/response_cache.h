@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+// What we keep from a fetched page: its links plus the validators needed
+// to revalidate it later.
+struct CacheEntry {
+    std::string url;
+    int statusCode = 0;
+    time_t fetchedAt = 0;
+    long maxAge = 0;             // Seconds the entry is fresh for
+    std::string etag;
+    std::string lastModified;
+    std::vector<std::string> links;
+
+    bool fresh(time_t now) const { return now - fetchedAt < maxAge; }
+};
+
+// On-disk cache of extracted link lists. Each entry is stored in a file
+// named after a hash of the normalized URL, under a two-level fan-out.
+class ResponseCache {
+public:
+    long defaultMaxAge = 24 * 60 * 60; // Used when the server gives no max-age
+
+    // Empty dir picks $XDG_CACHE_HOME/constellarix or ~/.cache/constellarix
+    bool open(const std::string& dir = "");
+    bool isOpen() const { return !root.empty(); }
+    const std::string& directory() const { return root; }
+
+    bool lookup(const std::string& url, CacheEntry& entry) const;
+    bool store(const CacheEntry& entry);
+
+    // Conditional request headers for revalidating a stale entry
+    static std::vector<std::string> validators(const CacheEntry& entry);
+    // Freshness lifetime from Cache-Control, or -1 for no-store
+    long maxAgeFor(const std::string& cacheControl) const;
+
+    static std::string normalizeKey(const std::string& url);
+
+private:
+    std::string root;
+
+    std::string pathFor(const std::string& key) const;
+};
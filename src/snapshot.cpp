@@ -0,0 +1,328 @@
+#include "snapshot.h"
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Bump when the layout changes; older files are rejected rather than guessed at
+static const uint32_t snapshotVersion = 1;
+static const char snapshotMagic[8] = {'C', 'X', 'G', 'R', 'A', 'P', 'H', '\0'};
+
+// Fixed-size header, followed by the sections in the order saveSnapshot()
+// writes them. Every section starts on an 8-byte boundary. Values are in
+// host byte order; a file from a machine of the other endianness fails
+// the byteOrder check.
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;  // 0x01020304 as written
+    uint64_t nodeCount;
+    uint64_t edgeCount;
+    uint64_t linkCount;  // Sum of all link list lengths
+    uint64_t urlCount;
+    uint64_t urlBytes;
+};
+
+const char* defaultSnapshotPath() {
+    return "constellarix.snapshot";
+}
+
+// Streams sections to a file, padding each one to the section alignment
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(FILE* f) : f(f) {}
+
+    template <typename T>
+    void section(const T* data, size_t count) {
+        write(data, count * sizeof(T));
+        static const char zeros[8] = {};
+        if (offset % 8) write(zeros, 8 - offset % 8);
+    }
+    template <typename T>
+    void section(const std::vector<T>& v) { section(v.data(), v.size()); }
+
+    bool ok() const { return good; }
+
+private:
+    FILE* f;
+    size_t offset = 0;
+    bool good = true;
+
+    void write(const void* data, size_t len) {
+        if (len && fwrite(data, 1, len, f) != len) good = false;
+        offset += len;
+    }
+};
+
+bool saveSnapshot(const Graph& graph, const std::string& path) {
+    // Compact: live nodes get consecutive indices, URLs are renumbered in
+    // order of first use so the file only carries strings still referenced
+    std::vector<int> slotToIndex(graph.nodes.size(), -1);
+    std::vector<int> slots;
+    for (size_t i = 0; i < graph.nodes.size(); i++) {
+        if (!graph.alive(i)) continue;
+        slotToIndex[i] = slots.size();
+        slots.push_back(i);
+    }
+    size_t n = slots.size();
+
+    std::vector<uint32_t> urlRemap(graph.urls.size(), UINT32_MAX);
+    std::vector<std::string_view> urlStrings;
+    auto mapUrl = [&](UrlId id) {
+        if (urlRemap[id] == UINT32_MAX) {
+            urlRemap[id] = urlStrings.size();
+            urlStrings.push_back(graph.urls.str(id));
+        }
+        return urlRemap[id];
+    };
+
+    std::vector<float> x(n), y(n), z(n), vx(n), vy(n), vz(n), size(n), targetSize(n);
+    std::vector<uint8_t> flags(n), status(n), expanded(n);
+    std::vector<int32_t> httpCode(n), parent(n);
+    std::vector<uint32_t> url(n);
+    std::vector<uint64_t> linkStart(n + 1);
+    std::vector<uint32_t> links;
+    for (size_t k = 0; k < n; k++) {
+        int i = slots[k];
+        const Node& node = graph.nodes[i];
+        x[k] = graph.sim.x[i]; y[k] = graph.sim.y[i]; z[k] = graph.sim.z[i];
+        vx[k] = graph.sim.vx[i]; vy[k] = graph.sim.vy[i]; vz[k] = graph.sim.vz[i];
+        size[k] = graph.sim.size[i];
+        targetSize[k] = node.targetSize;
+        flags[k] = graph.sim.flags[i] & NodePinned;
+        // A fetch in flight is not saved; the loader refetches pending nodes
+        status[k] = (uint8_t)node.status;
+        expanded[k] = node.expanded;
+        httpCode[k] = node.httpCode;
+        parent[k] = node.parentIndex >= 0 && node.parentIndex < (int)slotToIndex.size() ? slotToIndex[node.parentIndex] : -1;
+        url[k] = mapUrl(node.url);
+        linkStart[k] = links.size();
+        for (UrlId link : node.links) links.push_back(mapUrl(link));
+    }
+    linkStart[n] = links.size();
+
+    std::vector<int32_t> edgeEnds;
+    std::vector<float> restLength;
+    edgeEnds.reserve(graph.edges.size() * 2);
+    restLength.reserve(graph.edges.size());
+    for (const Edge& e : graph.edges) {
+        edgeEnds.push_back(slotToIndex[e.from]);
+        edgeEnds.push_back(slotToIndex[e.to]);
+        restLength.push_back(e.restLength);
+    }
+
+    std::vector<uint64_t> urlStart(urlStrings.size() + 1);
+    std::string urlBytes;
+    for (size_t u = 0; u < urlStrings.size(); u++) {
+        urlStart[u] = urlBytes.size();
+        urlBytes.append(urlStrings[u]);
+    }
+    urlStart[urlStrings.size()] = urlBytes.size();
+
+    SnapshotHeader header = {};
+    memcpy(header.magic, snapshotMagic, sizeof(header.magic));
+    header.version = snapshotVersion;
+    header.byteOrder = 0x01020304;
+    header.nodeCount = n;
+    header.edgeCount = restLength.size();
+    header.linkCount = links.size();
+    header.urlCount = urlStrings.size();
+    header.urlBytes = urlBytes.size();
+
+    std::string tmp = path + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (!f) {
+        std::cerr << "Cannot write snapshot " << tmp << ": " << strerror(errno) << "\n";
+        return false;
+    }
+    SnapshotWriter out(f);
+    out.section(&header, 1);
+    for (const auto* v : {&x, &y, &z, &vx, &vy, &vz, &size, &targetSize}) out.section(*v);
+    out.section(flags);
+    out.section(status);
+    out.section(expanded);
+    out.section(httpCode);
+    out.section(parent);
+    out.section(url);
+    out.section(linkStart);
+    out.section(links);
+    out.section(edgeEnds);
+    out.section(restLength);
+    out.section(urlStart);
+    out.section(urlBytes.data(), urlBytes.size());
+
+    // Data must be on disk before the rename makes it visible
+    bool ok = out.ok() && fflush(f) == 0 && fsync(fileno(f)) == 0;
+    ok = fclose(f) == 0 && ok;
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+        std::cerr << "Cannot write snapshot " << path << ": " << strerror(errno) << "\n";
+        unlink(tmp.c_str());
+        return false;
+    }
+
+    // Persist the rename itself
+    std::string dir = path.find('/') != std::string::npos ? path.substr(0, path.rfind('/') + 1) : ".";
+    int dirFd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dirFd >= 0) {
+        fsync(dirFd);
+        close(dirFd);
+    }
+    return true;
+}
+
+// Bounds-checked walk over the mapped sections
+class SnapshotReader {
+public:
+    SnapshotReader(const char* data, size_t size) : data(data), size(size) {}
+
+    template <typename T>
+    const T* section(uint64_t count) {
+        if (!good || count > (size - offset) / sizeof(T)) {
+            good = false;
+            return nullptr;
+        }
+        const T* p = reinterpret_cast<const T*>(data + offset);
+        offset += count * sizeof(T);
+        offset += (8 - offset % 8) % 8;
+        if (offset > size) offset = size; // Padding after the last section is optional
+        return p;
+    }
+    template <typename T>
+    bool copy(std::vector<T>& v, uint64_t count) {
+        const T* p = section<T>(count);
+        if (p) v.assign(p, p + count);
+        return p != nullptr;
+    }
+
+    bool ok() const { return good; }
+
+private:
+    const char* data;
+    size_t size;
+    size_t offset = 0;
+    bool good = true;
+};
+
+// Checks and copies everything out of the mapping without touching graph,
+// then swaps the result in
+static bool readSnapshot(Graph& graph, const char* data, size_t fileSize, const std::string& path) {
+    SnapshotReader in(data, fileSize);
+    const SnapshotHeader* header = in.section<SnapshotHeader>(1);
+    if (!header || memcmp(header->magic, snapshotMagic, sizeof(snapshotMagic)) != 0) {
+        std::cerr << path << " is not a snapshot\n";
+        return false;
+    }
+    if (header->version != snapshotVersion || header->byteOrder != 0x01020304) {
+        std::cerr << path << ": unsupported snapshot version " << header->version << "\n";
+        return false;
+    }
+    // Counts are checked against the file size before anything is allocated
+    uint64_t n = header->nodeCount;
+    if (n >= INT32_MAX || header->edgeCount > fileSize || header->linkCount > fileSize || header->urlCount >= UINT32_MAX) {
+        std::cerr << path << ": corrupt snapshot header\n";
+        return false;
+    }
+
+    NodeArrays sim;
+    std::vector<float> targetSize;
+    std::vector<uint8_t> status, expanded;
+    std::vector<int32_t> httpCode, parent;
+    for (auto* v : {&sim.x, &sim.y, &sim.z, &sim.vx, &sim.vy, &sim.vz, &sim.size, &targetSize}) in.copy(*v, n);
+    in.copy(sim.flags, n);
+    in.copy(status, n);
+    in.copy(expanded, n);
+    in.copy(httpCode, n);
+    in.copy(parent, n);
+    const uint32_t* url = in.section<uint32_t>(n);
+    const uint64_t* linkStart = in.section<uint64_t>(n + 1);
+    const uint32_t* links = in.section<uint32_t>(header->linkCount);
+    const int32_t* edgeEnds = in.section<int32_t>(header->edgeCount * 2);
+    const float* restLength = in.section<float>(header->edgeCount);
+    const uint64_t* urlStart = in.section<uint64_t>(header->urlCount + 1);
+    const char* urlBytes = in.section<char>(header->urlBytes);
+    if (!in.ok()) {
+        std::cerr << path << ": truncated snapshot\n";
+        return false;
+    }
+
+    // Every index must land inside its table
+    bool valid = linkStart[0] == 0 && linkStart[n] == header->linkCount &&
+                 urlStart[0] == 0 && urlStart[header->urlCount] == header->urlBytes;
+    for (uint64_t i = 0; valid && i < n; i++) {
+        valid = url[i] < header->urlCount && linkStart[i] <= linkStart[i + 1] &&
+                status[i] <= (uint8_t)NodeStatus::Error && parent[i] >= -1 && parent[i] < (int64_t)n &&
+                std::isfinite(sim.x[i] + sim.y[i] + sim.z[i] + sim.vx[i] + sim.vy[i] + sim.vz[i]) &&
+                std::isfinite(sim.size[i] + targetSize[i]);
+        sim.flags[i] &= NodePinned;
+    }
+    for (uint64_t l = 0; valid && l < header->linkCount; l++) valid = links[l] < header->urlCount;
+    for (uint64_t u = 0; valid && u < header->urlCount; u++) valid = urlStart[u] <= urlStart[u + 1];
+    if (!valid) {
+        std::cerr << path << ": corrupt snapshot\n";
+        return false;
+    }
+
+    std::vector<UrlId> urlIds(header->urlCount);
+    graph.urls.reserve(graph.urls.size() + header->urlCount);
+    for (uint64_t u = 0; u < header->urlCount; u++) {
+        urlIds[u] = graph.urls.intern(std::string_view(urlBytes + urlStart[u], urlStart[u + 1] - urlStart[u]));
+    }
+
+    std::vector<Node> nodes(n);
+    for (uint64_t i = 0; i < n; i++) {
+        Node& node = nodes[i];
+        node.url = urlIds[url[i]];
+        node.httpCode = httpCode[i];
+        node.parentIndex = parent[i];
+        node.targetSize = targetSize[i];
+        node.fadeIn = 1.0f;
+        node.status = (NodeStatus)status[i];
+        node.expanded = expanded[i];
+        node.links.resize(linkStart[i + 1] - linkStart[i]);
+        for (size_t l = 0; l < node.links.size(); l++) node.links[l] = urlIds[links[linkStart[i] + l]];
+    }
+
+    std::vector<Edge> edges(header->edgeCount);
+    for (uint64_t e = 0; e < header->edgeCount; e++) {
+        edges[e] = {edgeEnds[2 * e], edgeEnds[2 * e + 1], restLength[e], 1.0f};
+    }
+
+    graph.clear();
+    graph.nodes.swap(nodes);
+    graph.sim = std::move(sim);
+    graph.edges.swap(edges);
+    graph.rebuildIndexes(); // Also drops edges whose endpoints are out of range
+    return true;
+}
+
+bool loadSnapshot(Graph& graph, const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Cannot open snapshot " << path << ": " << strerror(errno) << "\n";
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(SnapshotHeader)) {
+        std::cerr << path << " is not a snapshot\n";
+        close(fd);
+        return false;
+    }
+    size_t fileSize = st.st_size;
+    void* mapped = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Cannot map snapshot " << path << ": " << strerror(errno) << "\n";
+        return false;
+    }
+    // Every array is read front to back exactly once
+    madvise(mapped, fileSize, MADV_SEQUENTIAL);
+
+    bool ok = readSnapshot(graph, (const char*)mapped, fileSize, path);
+    munmap(mapped, fileSize);
+    return ok;
+}
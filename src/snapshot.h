@@ -0,0 +1,17 @@
+#pragma once
+#include "graph.h"
+#include <string>
+
+// Versioned binary graph snapshot: node simulation arrays, per-node status,
+// link lists as URL ids, edges and the URL strings they refer to. Deleted
+// slots are compacted away on save.
+//
+// Saving writes to a temporary file, fsyncs it and renames it over the
+// target, so a crash leaves either the old or the new snapshot. Loading
+// maps the file and copies each bulk array out of the mapping in one go.
+bool saveSnapshot(const Graph& graph, const std::string& path);
+
+// Replaces the contents of graph. On failure graph is left untouched.
+bool loadSnapshot(Graph& graph, const std::string& path);
+
+const char* defaultSnapshotPath();
@@ -0,0 +1,103 @@
+#include "stream_buffer.h"
+#include <algorithm>
+#include <iostream>
+
+// Region offsets stay aligned for any vertex attribute
+static const size_t regionAlignment = 256;
+
+void StreamBuffer::init(size_t initialBytes) {
+    persistentMap = GLEW_ARB_buffer_storage;
+    glGenBuffers(1, &vbo);
+    allocate(initialBytes);
+}
+
+void StreamBuffer::shutdown() {
+    release();
+    if (vbo) glDeleteBuffers(1, &vbo);
+    vbo = 0;
+}
+
+void StreamBuffer::release() {
+    for (GLsync& f : fences) {
+        if (f) glDeleteSync(f);
+        f = nullptr;
+    }
+    if (persistentMap && mapped) {
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+    mapped = nullptr;
+}
+
+void StreamBuffer::allocate(size_t bytes) {
+    regionSize = (std::max(bytes, regionAlignment) + regionAlignment - 1) / regionAlignment * regionAlignment;
+    region = 0;
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    if (!persistentMap) {
+        glBufferData(GL_ARRAY_BUFFER, regionSize, nullptr, GL_STREAM_DRAW);
+        return;
+    }
+
+    // Immutable storage can't be resized, so growing means a new buffer;
+    // the driver keeps the old one alive until pending draws are done
+    if (mapped) {
+        release();
+        glDeleteBuffers(1, &vbo);
+        glGenBuffers(1, &vbo);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    }
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(GL_ARRAY_BUFFER, regionSize * regionCount, nullptr, flags);
+    mapped = (uint8_t*)glMapBufferRange(GL_ARRAY_BUFFER, 0, regionSize * regionCount, flags);
+    if (!mapped) {
+        // Fall back to orphaning for the rest of the run
+        std::cerr << "Persistent buffer mapping failed, streaming by orphaning\n";
+        persistentMap = false;
+        glDeleteBuffers(1, &vbo);
+        glGenBuffers(1, &vbo);
+        allocate(bytes);
+    }
+}
+
+void StreamBuffer::wait(int r) {
+    if (!fences[r]) return;
+    // Normally long signalled: the region was drawn from two frames ago
+    while (glClientWaitSync(fences[r], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {
+    }
+    glDeleteSync(fences[r]);
+    fences[r] = nullptr;
+}
+
+void* StreamBuffer::map(size_t bytes) {
+    if (bytes > regionSize) allocate(std::max(bytes, regionSize * 2));
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    if (persistentMap) {
+        region = (region + 1) % regionCount;
+        wait(region);
+        return mapped + region * regionSize;
+    }
+
+    // Orphan: the driver hands out fresh storage while the GPU finishes with the old
+    glBufferData(GL_ARRAY_BUFFER, regionSize, nullptr, GL_STREAM_DRAW);
+    if (bytes == 0) return nullptr;
+    mapped = (uint8_t*)glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    return mapped;
+}
+
+size_t StreamBuffer::commit() {
+    if (persistentMap) return region * regionSize; // Coherent mapping, nothing to flush
+
+    if (mapped) {
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        mapped = nullptr;
+    }
+    return 0;
+}
+
+void StreamBuffer::fence() {
+    if (!persistentMap) return;
+    if (fences[region]) glDeleteSync(fences[region]);
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
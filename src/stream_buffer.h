@@ -0,0 +1,45 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstddef>
+#include <cstdint>
+
+// Vertex data rewritten every frame. With GL_ARB_buffer_storage the buffer
+// is mapped once, persistently, and split into three regions written in
+// turn; a fence per region keeps the CPU from overwriting data the GPU is
+// still drawing from. Without it every map() orphans the buffer instead.
+// Either way the buffer grows whenever a frame needs more room, so there
+// is no cap on the amount of data.
+//
+// Each map() takes a fresh region: use one StreamBuffer per draw per frame.
+// GL objects are released by shutdown(), while the context is current.
+class StreamBuffer {
+public:
+    static const int regionCount = 3;
+
+    void init(size_t initialBytes);
+    void shutdown();
+
+    // Write-only memory for up to bytes of data, valid until commit(). The
+    // buffer is bound to GL_ARRAY_BUFFER and may have been reallocated, so
+    // vertex attributes have to be pointed at buffer() again after this.
+    void* map(size_t bytes);
+    // Ends the writes and returns the offset of the data in buffer()
+    size_t commit();
+    // Call after the draw that reads the committed data
+    void fence();
+
+    GLuint buffer() const { return vbo; }
+    bool persistent() const { return persistentMap; }
+
+private:
+    GLuint vbo = 0;
+    bool persistentMap = false;
+    uint8_t* mapped = nullptr;    // Whole buffer when persistent, else the current map
+    size_t regionSize = 0;
+    int region = 0;
+    GLsync fences[regionCount] = {};
+
+    void allocate(size_t bytes);
+    void release();
+    void wait(int r);
+};
@@ -0,0 +1,64 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(int threadCount) {
+    threadCount = std::max(1, threadCount);
+    for (int i = 1; i < threadCount; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+void ThreadPool::run(const std::function<void(int)>& task) {
+    if (workers.empty()) {
+        task(0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &task;
+        remaining = (int)workers.size();
+        generation++;
+    }
+    wake.notify_all();
+
+    task(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] { return remaining == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::workerLoop(int index) {
+    unsigned seen = 0;
+    while (true) {
+        const std::function<void(int)>* current;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            current = job;
+        }
+
+        (*current)(index);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--remaining == 0) finished.notify_one();
+    }
+}
+
+void ThreadPool::splitRange(int count, int parts, int part, int& begin, int& end) {
+    int base = count / parts, extra = count % parts;
+    begin = part * base + std::min(part, extra);
+    end = begin + base + (part < extra ? 1 : 0);
+}
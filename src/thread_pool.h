@@ -0,0 +1,34 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent fork-join pool. run() hands every worker one task index and
+// blocks until all of them finish; task 0 executes on the calling thread.
+class ThreadPool {
+public:
+    explicit ThreadPool(int threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return (int)workers.size() + 1; }
+    void run(const std::function<void(int)>& task);
+
+    // Split [0, count) into parts and return the bounds of one of them
+    static void splitRange(int count, int parts, int part, int& begin, int& end);
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, finished;
+    const std::function<void(int)>* job = nullptr;
+    unsigned generation = 0;
+    int remaining = 0;
+    bool stopping = false;
+
+    void workerLoop(int index);
+};
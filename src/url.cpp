@@ -0,0 +1,473 @@
+#include "url.h"
+#include <algorithm>
+#include <cstring>
+
+static const char hexDigits[] = "0123456789ABCDEF";
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static char lowerAscii(char c) {
+    return (c >= 'A' && c <= 'Z') ? c + 32 : c;
+}
+
+static bool isAlpha(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static bool isSlash(char c) {
+    return c == '/' || c == '\\'; // Special schemes treat backslash as slash
+}
+
+static bool isUnreserved(unsigned char c) {
+    return isAlpha(c) || isDigit(c) || c == '-' || c == '.' || c == '_' || c == '~';
+}
+
+static bool equalsIgnoreCase(std::string_view a, const char* b) {
+    size_t n = strlen(b);
+    if (a.size() != n) return false;
+    for (size_t i = 0; i < n; i++) {
+        if (lowerAscii(a[i]) != b[i]) return false;
+    }
+    return true;
+}
+
+// Percent-encode sets per component, on top of controls, space and non-ASCII
+enum class Component { Path, Query, Fragment };
+
+static bool mustEncode(unsigned char c, Component component) {
+    if (c <= 0x20 || c >= 0x7F) return true;
+    switch (component) {
+    case Component::Path:
+        return c == '"' || c == '<' || c == '>' || c == '`' || c == '{' || c == '}' || c == '#' || c == '?';
+    case Component::Query:
+        return c == '"' || c == '<' || c == '>' || c == '#' || c == '\'';
+    case Component::Fragment:
+        return c == '"' || c == '<' || c == '>' || c == '`';
+    }
+    return false;
+}
+
+// Escapes are written in upper case, and escaped unreserved characters are
+// decoded, so every spelling of the same byte sequence comes out the same
+static void appendEncoded(std::string& out, std::string_view s, Component component) {
+    for (size_t i = 0; i < s.size(); i++) {
+        unsigned char c = s[i];
+        if (c == '%') {
+            int hi = i + 2 < s.size() ? hexValue(s[i + 1]) : -1;
+            int lo = i + 2 < s.size() ? hexValue(s[i + 2]) : -1;
+            if (hi >= 0 && lo >= 0) {
+                unsigned char decoded = (unsigned char)(hi * 16 + lo);
+                if (isUnreserved(decoded)) {
+                    out.push_back((char)decoded);
+                } else {
+                    out.push_back('%');
+                    out.push_back(hexDigits[hi]);
+                    out.push_back(hexDigits[lo]);
+                }
+                i += 2;
+            } else {
+                out.push_back('%');
+            }
+        } else if (mustEncode(c, component)) {
+            out.push_back('%');
+            out.push_back(hexDigits[c >> 4]);
+            out.push_back(hexDigits[c & 15]);
+        } else {
+            out.push_back((char)c);
+        }
+    }
+}
+
+static bool isDotSegment(std::string_view seg) {
+    return seg == "." || equalsIgnoreCase(seg, "%2e");
+}
+
+static bool isDoubleDotSegment(std::string_view seg) {
+    return seg == ".." || equalsIgnoreCase(seg, ".%2e") || equalsIgnoreCase(seg, "%2e.") ||
+           equalsIgnoreCase(seg, "%2e%2e");
+}
+
+static bool isTrackingParam(std::string_view key) {
+    static const char* names[] = {"fbclid", "gclid", "dclid", "gbraid", "wbraid", "msclkid", "mc_cid",
+                                  "mc_eid", "igshid", "yclid", "_hsenc", "_hsmi"};
+    if (key.size() > 4 && equalsIgnoreCase(key.substr(0, 4), "utm_")) return true;
+    for (const char* name : names) {
+        if (equalsIgnoreCase(key, name)) return true;
+    }
+    return false;
+}
+
+static std::string_view paramKey(std::string_view param) {
+    return param.substr(0, param.find('='));
+}
+
+// Splits "path?query#fragment" (any part may be missing)
+struct RefParts {
+    std::string_view path, query, fragment;
+    bool hasQuery = false, hasFragment = false;
+};
+
+static RefParts splitRef(std::string_view s) {
+    RefParts parts;
+    size_t hash = s.find('#');
+    if (hash != std::string_view::npos) {
+        parts.fragment = s.substr(hash + 1);
+        parts.hasFragment = true;
+        s = s.substr(0, hash);
+    }
+    size_t question = s.find('?');
+    if (question != std::string_view::npos) {
+        parts.query = s.substr(question + 1);
+        parts.hasQuery = true;
+        s = s.substr(0, question);
+    }
+    parts.path = s;
+    return parts;
+}
+
+std::string_view UrlArena::store(std::string_view s) {
+    used += s.size();
+    // Long strings get a block of their own so they don't waste the current one
+    if (s.size() > blockSize / 4) {
+        blocks.push_back(std::make_unique<char[]>(s.size()));
+        memcpy(blocks.back().get(), s.data(), s.size());
+        return std::string_view(blocks.back().get(), s.size());
+    }
+    if (!current || blockUsed + s.size() > blockSize) {
+        blocks.push_back(std::make_unique<char[]>(blockSize));
+        current = blocks.back().get();
+        blockUsed = 0;
+    }
+    char* dst = current + blockUsed;
+    memcpy(dst, s.data(), s.size());
+    blockUsed += s.size();
+    return std::string_view(dst, s.size());
+}
+
+void UrlArena::reset() {
+    blocks.clear();
+    current = nullptr;
+    blockUsed = blockSize;
+    used = 0;
+}
+
+UrlTable::UrlTable() {
+    strings.emplace_back();
+    slots.assign(64, 0);
+}
+
+void UrlTable::reserve(size_t count) {
+    strings.reserve(count);
+    size_t want = slots.size();
+    while (want < count * 2) want *= 2;
+    if (want != slots.size()) rehash(want);
+}
+
+void UrlTable::rehash(size_t slotCount) {
+    std::vector<uint64_t> old(slotCount, 0);
+    old.swap(slots);
+    size_t mask = slots.size() - 1;
+    for (uint64_t entry : old) {
+        if (!entry) continue;
+        size_t s = (entry >> 32) & mask;
+        while (slots[s]) s = (s + 1) & mask;
+        slots[s] = entry;
+    }
+}
+
+// Linear probing. Each slot holds the upper hash bits next to the id, so
+// most mismatches are rejected without touching the string.
+size_t UrlTable::probe(std::string_view url, uint32_t hash) const {
+    size_t mask = slots.size() - 1;
+    for (size_t s = hash & mask;; s = (s + 1) & mask) {
+        uint64_t entry = slots[s];
+        if (!entry) return s;
+        if ((uint32_t)(entry >> 32) == hash && strings[(uint32_t)entry] == url) return s;
+    }
+}
+
+UrlId UrlTable::intern(std::string_view url) {
+    if (url.empty()) return none;
+    uint32_t hash = std::hash<std::string_view>()(url);
+    size_t s = probe(url, hash);
+    if (slots[s]) return (uint32_t)slots[s];
+
+    UrlId id = strings.size();
+    strings.push_back(arena.store(url));
+    slots[s] = ((uint64_t)hash << 32) | id;
+    // Keep the load factor under one half
+    if (strings.size() * 2 > slots.size()) rehash(slots.size() * 2);
+    return id;
+}
+
+UrlId UrlTable::find(std::string_view url) const {
+    if (url.empty()) return none;
+    return (uint32_t)slots[probe(url, std::hash<std::string_view>()(url))];
+}
+
+UrlResolver::UrlResolver(UrlOptions options) : options(options) {}
+
+bool UrlResolver::setBase(std::string_view url) {
+    // The base itself must be absolute
+    bool hadBase = hasBase;
+    hasBase = false;
+    Parts parts;
+    bool ok = build(url, &parts);
+    hasBase = hadBase;
+    if (!ok) return false;
+
+    baseUrl = out;
+    baseParts = std::move(parts);
+    hasBase = true;
+    return true;
+}
+
+std::string_view UrlResolver::resolve(std::string_view ref, UrlArena& arena) {
+    if (!build(ref, nullptr)) return {};
+    return arena.store(out);
+}
+
+std::string_view UrlResolver::resolve(std::string_view ref) {
+    if (!build(ref, nullptr)) return {};
+    return out;
+}
+
+bool UrlResolver::appendAuthority(std::string_view authority, const std::string& scheme, Parts* parts) {
+    // Credentials are dropped from the canonical form
+    size_t at = authority.rfind('@');
+    if (at != std::string_view::npos) authority = authority.substr(at + 1);
+
+    std::string_view host, port;
+    if (!authority.empty() && authority[0] == '[') {
+        size_t close = authority.find(']');
+        if (close == std::string_view::npos) return false;
+        host = authority.substr(0, close + 1);
+        std::string_view rest = authority.substr(close + 1);
+        if (!rest.empty()) {
+            if (rest[0] != ':') return false;
+            port = rest.substr(1);
+        }
+    } else {
+        size_t colon = authority.rfind(':');
+        host = authority.substr(0, colon);
+        if (colon != std::string_view::npos) port = authority.substr(colon + 1);
+    }
+    if (host.empty()) return false;
+
+    // Internationalized names have to arrive already in punycode; raw UTF-8
+    // hosts are rejected rather than canonicalized two different ways
+    size_t hostBegin = out.size();
+    for (char c : host) {
+        unsigned char u = c;
+        if (u <= 0x20 || u >= 0x7F || strchr("#%/<>?@\\^|", c)) return false;
+        out.push_back(lowerAscii(c));
+    }
+    if (parts) parts->host = out.substr(hostBegin);
+
+    if (!port.empty()) {
+        long value = 0;
+        for (char c : port) {
+            if (!isDigit(c)) return false;
+            value = value * 10 + (c - '0');
+            if (value > 65535) return false;
+        }
+        long defaultPort = scheme == "https" ? 443 : 80;
+        if (value != defaultPort) {
+            out.push_back(':');
+            size_t portBegin = out.size();
+            out.append(std::to_string(value));
+            if (parts) parts->port = out.substr(portBegin);
+        }
+    }
+    return true;
+}
+
+void UrlResolver::appendPath(std::string_view path) {
+    // path starts with a separator; dot segments are resolved as they are copied
+    out.push_back('/');
+    segmentStarts.clear();
+    size_t i = 1;
+    while (true) {
+        size_t end = i;
+        while (end < path.size() && !isSlash(path[end])) end++;
+        std::string_view seg = path.substr(i, end - i);
+        bool last = end >= path.size();
+
+        if (isDotSegment(seg)) {
+            // Dropped; the output already ends in a slash
+        } else if (isDoubleDotSegment(seg)) {
+            if (!segmentStarts.empty()) {
+                out.resize(segmentStarts.back());
+                segmentStarts.pop_back();
+            }
+        } else {
+            segmentStarts.push_back(out.size());
+            appendEncoded(out, seg, Component::Path);
+            if (!last) out.push_back('/');
+        }
+
+        if (last) break;
+        i = end + 1;
+    }
+}
+
+void UrlResolver::appendQuery(std::string_view q) {
+    size_t mark = out.size();
+    out.push_back('?');
+
+    if (!options.dropTrackingParams && !options.sortQuery) {
+        appendEncoded(out, q, Component::Query);
+    } else {
+        params.clear();
+        size_t start = 0;
+        while (start <= q.size()) {
+            size_t amp = q.find('&', start);
+            if (amp == std::string_view::npos) amp = q.size();
+            std::string_view param = q.substr(start, amp - start);
+            if (!param.empty() && !(options.dropTrackingParams && isTrackingParam(paramKey(param)))) {
+                params.push_back(param);
+            }
+            start = amp + 1;
+        }
+        if (options.sortQuery) {
+            std::stable_sort(params.begin(), params.end(), [](std::string_view a, std::string_view b) {
+                return paramKey(a) < paramKey(b);
+            });
+        }
+        for (size_t p = 0; p < params.size(); p++) {
+            if (p > 0) out.push_back('&');
+            appendEncoded(out, params[p], Component::Query);
+        }
+    }
+
+    // An empty query is the same resource as no query
+    if (out.size() == mark + 1) out.resize(mark);
+}
+
+bool UrlResolver::build(std::string_view ref, Parts* parts) {
+    // Leading/trailing controls and spaces are ignored, tabs and newlines anywhere
+    size_t b = 0, e = ref.size();
+    while (b < e && (unsigned char)ref[b] <= 0x20) b++;
+    while (e > b && (unsigned char)ref[e - 1] <= 0x20) e--;
+    ref = ref.substr(b, e - b);
+    if (ref.find_first_of("\t\n\r") != std::string_view::npos) {
+        cleaned.clear();
+        for (char c : ref) {
+            if (c != '\t' && c != '\n' && c != '\r') cleaned.push_back(c);
+        }
+        ref = cleaned;
+    }
+
+    // Scheme
+    size_t colon = std::string_view::npos;
+    if (!ref.empty() && isAlpha(ref[0])) {
+        size_t j = 1;
+        while (j < ref.size() && (isAlpha(ref[j]) || isDigit(ref[j]) || ref[j] == '+' || ref[j] == '-' || ref[j] == '.')) j++;
+        if (j < ref.size() && ref[j] == ':') colon = j;
+    }
+
+    const char* scheme = nullptr;
+    std::string_view rest = ref;
+    bool relative = true;
+    if (colon != std::string_view::npos) {
+        std::string_view name = ref.substr(0, colon);
+        if (equalsIgnoreCase(name, "http")) scheme = "http";
+        else if (equalsIgnoreCase(name, "https")) scheme = "https";
+        else return false; // javascript:, mailto:, data:, ...
+        rest = ref.substr(colon + 1);
+        // "http:foo" is relative when the base has the same scheme
+        bool sameScheme = hasBase && baseParts.scheme == scheme;
+        if (!sameScheme || (!rest.empty() && isSlash(rest[0]))) relative = false;
+    } else if (!hasBase) {
+        return false;
+    }
+    std::string schemeName = scheme ? scheme : baseParts.scheme;
+
+    out.clear();
+    out.append(schemeName);
+    out.append("://");
+    if (parts) parts->scheme = schemeName;
+
+    bool hasAuthority = !relative || (rest.size() >= 2 && isSlash(rest[0]) && isSlash(rest[1]));
+    size_t pathBegin;
+    RefParts split;
+    if (hasAuthority) {
+        // Special schemes ignore any number of slashes before the host
+        size_t k = 0;
+        while (k < rest.size() && isSlash(rest[k])) k++;
+        rest = rest.substr(k);
+        size_t authEnd = rest.find_first_of("/\\?#");
+        if (!appendAuthority(rest.substr(0, authEnd), schemeName, parts)) return false;
+        rest = authEnd == std::string_view::npos ? std::string_view() : rest.substr(authEnd);
+
+        split = splitRef(rest);
+        pathBegin = out.size();
+        appendPath(split.path.empty() ? std::string_view("/") : split.path);
+        if (split.hasQuery) appendQuery(split.query);
+    } else {
+        out.append(baseParts.host);
+        if (!baseParts.port.empty()) {
+            out.push_back(':');
+            out.append(baseParts.port);
+        }
+        if (parts) {
+            parts->host = baseParts.host;
+            parts->port = baseParts.port;
+        }
+
+        split = splitRef(rest);
+        pathBegin = out.size();
+        if (split.path.empty()) {
+            // Same document: keep the base path, and its query unless a new one is given
+            out.append(baseParts.path);
+            if (split.hasQuery) {
+                appendQuery(split.query);
+            } else if (!baseParts.query.empty()) {
+                out.push_back('?');
+                out.append(baseParts.query);
+            }
+        } else {
+            if (isSlash(split.path[0])) {
+                appendPath(split.path);
+            } else {
+                // Merge with the directory of the base path
+                merged.assign(baseParts.path, 0, baseParts.path.rfind('/') + 1);
+                merged.append(split.path);
+                appendPath(merged);
+            }
+            if (split.hasQuery) appendQuery(split.query);
+        }
+    }
+
+    if (parts) {
+        size_t queryMark = out.find('?', pathBegin);
+        if (queryMark == std::string::npos) {
+            parts->path = out.substr(pathBegin);
+            parts->query.clear();
+        } else {
+            parts->path = out.substr(pathBegin, queryMark - pathBegin);
+            parts->query = out.substr(queryMark + 1);
+        }
+    }
+
+    if (split.hasFragment && !options.stripFragment) {
+        out.push_back('#');
+        appendEncoded(out, split.fragment, Component::Fragment);
+    }
+    return true;
+}
+
+std::string canonicalUrl(std::string_view url, const UrlOptions& options) {
+    UrlResolver resolver(options);
+    if (!resolver.setBase(url)) return "";
+    return resolver.base();
+}
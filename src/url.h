@@ -0,0 +1,104 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Which equivalent spellings of a URL collapse onto one canonical form.
+// Scheme/host case, default ports, dot segments and percent-encoding are
+// always normalized.
+struct UrlOptions {
+    bool stripFragment = true;      // Fragments never reach the server
+    bool sortQuery = false;         // ?b=1&a=2 and ?a=2&b=1 become the same URL
+    bool dropTrackingParams = true; // utm_*, fbclid, gclid, ...
+};
+
+// Bump allocator for URL strings. Views handed out stay valid until reset().
+class UrlArena {
+public:
+    std::string_view store(std::string_view s);
+    void reset();
+    size_t bytesUsed() const { return used; }
+
+private:
+    static const size_t blockSize = 16 * 1024;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* current = nullptr;
+    size_t blockUsed = blockSize; // Forces a block on first use
+    size_t used = 0;
+};
+
+using UrlId = uint32_t;
+
+// Intern table: every distinct URL is stored once in an arena and named by
+// a 32-bit id, so link lists hold ids and equal URLs compare as integers.
+// Ids and the views returned by str() stay valid for the table's lifetime.
+// Not thread-safe; views may be read from other threads since the arena
+// never moves stored bytes.
+class UrlTable {
+public:
+    static constexpr UrlId none = 0; // Always the empty string
+
+    UrlTable();
+    UrlId intern(std::string_view url);
+    // Id of a URL interned earlier, or none
+    UrlId find(std::string_view url) const;
+    std::string_view str(UrlId id) const { return strings[id]; }
+    // Room for count URLs in total without rehashing
+    void reserve(size_t count);
+
+    size_t size() const { return strings.size(); }
+    size_t bytesUsed() const { return arena.bytesUsed(); }
+
+private:
+    UrlArena arena;
+    std::vector<std::string_view> strings; // Indexed by id
+    std::vector<uint64_t> slots;           // Hash table: hash << 32 | id, 0 = empty
+
+    size_t probe(std::string_view url, uint32_t hash) const;
+    void rehash(size_t slotCount);
+};
+
+// WHATWG-style parser for http(s) URLs. Relative references are resolved
+// against the base set with setBase(); the result is written in canonical
+// form: lowercase scheme and host, no default port or credentials, dot
+// segments removed and percent-encoding normalized.
+class UrlResolver {
+public:
+    explicit UrlResolver(UrlOptions options = {});
+
+    // Accepts an absolute http(s) URL; returns false (and keeps the old base) otherwise
+    bool setBase(std::string_view url);
+    const std::string& base() const { return baseUrl; }
+
+    // Canonical absolute URL, or an empty view for non-http(s) and malformed
+    // references. The view points into the arena.
+    std::string_view resolve(std::string_view ref, UrlArena& arena);
+    // Same, but into a buffer owned by the resolver, valid until the next call
+    std::string_view resolve(std::string_view ref);
+
+private:
+    struct Parts {
+        std::string scheme, host, port, path, query;
+    };
+
+    UrlOptions options;
+    std::string baseUrl;
+    Parts baseParts;
+    bool hasBase = false;
+
+    // Reused between calls so resolving does not allocate once warmed up
+    std::string cleaned, out, merged, query;
+    std::vector<size_t> segmentStarts;
+    std::vector<std::string_view> params;
+
+    bool build(std::string_view ref, Parts* parts);
+    bool appendAuthority(std::string_view authority, const std::string& scheme, Parts* parts);
+    void appendPath(std::string_view path);
+    void appendQuery(std::string_view q);
+};
+
+// Canonical form of an absolute URL, or "" if it is not a valid http(s) URL
+std::string canonicalUrl(std::string_view url, const UrlOptions& options = {});